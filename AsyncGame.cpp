@@ -0,0 +1,345 @@
+#include "AsyncGame.h"
+#include "ThreadPool.h"
+#include "Board.h"
+#include "Game.h"
+#include "Player.h"
+#include "GameRecord.h"
+#include "globals.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//******************** SyncPlayerAdapter *******************************
+
+SyncPlayerAdapter::SyncPlayerAdapter(Player* p)
+ : m_player(p)
+{}
+
+SyncPlayerAdapter::~SyncPlayerAdapter()
+{
+    delete m_player;
+}
+
+string SyncPlayerAdapter::name() const
+{
+    return m_player->name();
+}
+
+void SyncPlayerAdapter::recordOpponent(string nm)
+{
+    m_player->recordOpponent(nm);
+}
+
+void SyncPlayerAdapter::requestPlacement(Board& b, function<void(bool)> done)
+{
+    done(m_player->placeShips(b));
+}
+
+void SyncPlayerAdapter::requestAttack(function<void(Point)> done)
+{
+    done(m_player->recommendAttack());
+}
+
+void SyncPlayerAdapter::recordAttackResult(Point p, bool validShot,
+                                           bool shotHit, bool shipDestroyed,
+                                           int shipId)
+{
+    m_player->recordAttackResult(p, validShot, shotHit, shipDestroyed, shipId);
+}
+
+void SyncPlayerAdapter::recordAttackByOpponent(Point p)
+{
+    m_player->recordAttackByOpponent(p);
+}
+
+//******************** one suspendable game ****************************
+
+  // A game as a state machine: each stage names the answer the game is
+  // waiting for, and advance runs stages until an answer isn't in yet.
+class AsyncGameState
+{
+  public:
+    AsyncGameState(GameSchedulerImpl& scheduler, const Game& g,
+                   AsyncPlayer& p1, AsyncPlayer& p2, unsigned seed,
+                   GameRecord* record, function<void()> over);
+    void advance();
+
+  private:
+    enum Stage { START, PLACING_FIRST, PLACING_SECOND, ATTACKING };
+    bool awaitPlacement(AsyncPlayer& p, Board& b);
+    bool awaitAttack(AsyncPlayer& p);
+    bool depart();
+    void arrive();
+    void finish(int winner);
+
+    GameSchedulerImpl& m_scheduler;
+    const Game& m_game;
+    AsyncPlayer* m_players[2];
+    Board m_b1;
+    Board m_b2;
+    GameRecord m_record;
+    GameRecord* m_out;
+    function<void()> m_over;
+    mt19937 m_engine;       // the game's random stream while it's suspended
+    Stage m_stage;
+    int m_turn;             // 0 or 1: who made the attack being waited on
+
+      // The answer being waited on, and a count of the two events that must
+      // both happen before the game can go on: the request returning, and
+      // the answer arriving.  Whichever comes second carries on the game.
+    bool m_placed;
+    Point m_attack;
+    atomic<int> m_arrivals;
+};
+
+class GameSchedulerImpl
+{
+  public:
+    GameSchedulerImpl(int nThreads);
+    void add(const Game& g, AsyncPlayer& p1, AsyncPlayer& p2, unsigned seed,
+             GameRecord* record);
+    void run();
+    void launch(const Game& g, AsyncPlayer& p1, AsyncPlayer& p2,
+                unsigned seed, GameRecord* record, function<void()> over);
+    void resume(AsyncGameState* game);
+    void gameOver(AsyncGameState* game, function<void()> over);
+
+  private:
+    vector<unique_ptr<AsyncGameState>> m_queued;
+    mutex m_mutex;
+    condition_variable m_allOver;
+    int m_unfinished;
+      // Last, so it's destroyed first, finishing every task that might
+      // still be using the members above
+    WorkStealingPool m_pool;
+};
+
+AsyncGameState::AsyncGameState(GameSchedulerImpl& scheduler, const Game& g,
+                               AsyncPlayer& p1, AsyncPlayer& p2,
+                               unsigned seed, GameRecord* record,
+                               function<void()> over)
+ : m_scheduler(scheduler), m_game(g), m_b1(g), m_b2(g), m_out(record),
+   m_over(over), m_engine(seed), m_stage(START), m_turn(0), m_placed(false), m_arrivals(0)
+{
+    m_players[0] = &p1;
+    m_players[1] = &p2;
+    m_record.seed = seed;
+}
+
+  // The request has returned: save the stream for whichever thread carries
+  // on, and say whether the answer was already in
+bool AsyncGameState::depart()
+{
+    m_engine = randomEngine();
+    return ++m_arrivals == 2;
+}
+
+  // The answer is in; if the request has returned too, queue the game
+void AsyncGameState::arrive()
+{
+    if (++m_arrivals == 2)
+        m_scheduler.resume(this);
+}
+
+bool AsyncGameState::awaitPlacement(AsyncPlayer& p, Board& b)
+{
+    m_arrivals = 0;
+    p.requestPlacement(b, [this](bool placed) { m_placed = placed; arrive(); });
+    return depart();
+}
+
+bool AsyncGameState::awaitAttack(AsyncPlayer& p)
+{
+    m_arrivals = 0;
+    p.requestAttack([this](Point a) { m_attack = a; arrive(); });
+    return depart();
+}
+
+  // The last thing a game does; the scheduler may delete it before this
+  // returns
+void AsyncGameState::finish(int winner)
+{
+    m_record.winner = winner;
+    if (m_out != nullptr)
+        *m_out = m_record;
+    m_scheduler.gameOver(this, move(m_over));
+}
+
+  // Runs the game on this thread until it has to wait for a player.  When
+  // an await returns false, another thread may already have the game, so
+  // nothing here may touch it after that.
+void AsyncGameState::advance()
+{
+    randomEngine() = m_engine;
+    for (;;)
+    {
+        switch (m_stage)
+        {
+          case START:
+            m_players[0]->recordOpponent(m_players[1]->name());
+            m_players[1]->recordOpponent(m_players[0]->name());
+            m_stage = PLACING_FIRST;
+            if (!awaitPlacement(*m_players[0], m_b1))
+                return;
+            break;
+
+          case PLACING_FIRST:
+            if (!m_placed)
+            {
+                finish(0);
+                return;
+            }
+            m_stage = PLACING_SECOND;
+            if (!awaitPlacement(*m_players[1], m_b2))
+                return;
+            break;
+
+          case PLACING_SECOND:
+            if (!m_placed)
+            {
+                finish(0);
+                return;
+            }
+            for (int k = 0; k < m_game.nShips(); k++)
+            {
+                ShipPlacement s1;
+                ShipPlacement s2;
+                m_b1.shipPlacement(k, s1.topOrLeft, s1.orientation);
+                m_b2.shipPlacement(k, s2.topOrLeft, s2.orientation);
+                m_record.layouts[0].push_back(s1);
+                m_record.layouts[1].push_back(s2);
+            }
+            m_stage = ATTACKING;
+            m_turn = 0;
+            if (!awaitAttack(*m_players[0]))
+                return;
+            break;
+
+          case ATTACKING:
+          {
+              // The same steps, in the same order, as Game::play
+            AsyncPlayer& attacker = *m_players[m_turn];
+            AsyncPlayer& defender = *m_players[1 - m_turn];
+            Board& target = (m_turn == 0 ? m_b2 : m_b1);
+            Point p = m_attack;
+            bool shotHit = false;
+            bool shipDestroyed = false;
+            int shipId = 100;
+            bool validShot = target.attack(p, shotHit, shipDestroyed, shipId);
+            m_record.addShot(m_turn, p, validShot, shotHit, shipDestroyed, shipId);
+            if (validShot)
+            {
+                attacker.recordAttackResult(p, true, shotHit, shipDestroyed, shipId);
+                defender.recordAttackByOpponent(p);
+                if (target.allShipsDestroyed())
+                {
+                    finish(m_turn + 1);
+                    return;
+                }
+            }
+            m_turn = 1 - m_turn;
+            if (!awaitAttack(*m_players[m_turn]))
+                return;
+            break;
+          }
+        }
+    }
+}
+
+//******************** scheduler ***************************************
+
+GameSchedulerImpl::GameSchedulerImpl(int nThreads)
+ : m_unfinished(0), m_pool(nThreads)
+{}
+
+void GameSchedulerImpl::add(const Game& g, AsyncPlayer& p1, AsyncPlayer& p2,
+                            unsigned seed, GameRecord* record)
+{
+    m_queued.push_back(unique_ptr<AsyncGameState>(
+              new AsyncGameState(*this, g, p1, p2, seed, record, nullptr)));
+}
+
+void GameSchedulerImpl::launch(const Game& g, AsyncPlayer& p1, AsyncPlayer& p2,
+                               unsigned seed, GameRecord* record,
+                               function<void()> over)
+{
+    AsyncGameState* game = new AsyncGameState(*this, g, p1, p2, seed, record,
+                                              over);
+    {
+        lock_guard<mutex> lk(m_mutex);
+        m_unfinished++;
+    }
+    resume(game);
+}
+
+void GameSchedulerImpl::resume(AsyncGameState* game)
+{
+    m_pool.submit([game]() { game->advance(); });
+}
+
+  // Every game, queued or launched, belongs to the scheduler once it
+  // starts, and is deleted here as it ends
+void GameSchedulerImpl::gameOver(AsyncGameState* game, function<void()> over)
+{
+    delete game;
+    if (over)
+        over();
+    lock_guard<mutex> lk(m_mutex);
+    if (--m_unfinished == 0)
+        m_allOver.notify_all();
+}
+
+void GameSchedulerImpl::run()
+{
+    {
+        lock_guard<mutex> lk(m_mutex);
+        m_unfinished += m_queued.size();
+    }
+    for (size_t k = 0; k < m_queued.size(); k++)
+        resume(m_queued[k].release());
+    m_queued.clear();
+
+      // The pool can run dry while games wait on players, so it's the
+      // games, not the pool's tasks, that say when we're done
+    unique_lock<mutex> lk(m_mutex);
+    m_allOver.wait(lk, [this]() { return m_unfinished == 0; });
+}
+
+//******************** GameScheduler functions *************************
+
+// These functions simply delegate to GameSchedulerImpl's functions.
+
+GameScheduler::GameScheduler(int nThreads)
+{
+    m_impl = new GameSchedulerImpl(nThreads);
+}
+
+GameScheduler::~GameScheduler()
+{
+    delete m_impl;
+}
+
+void GameScheduler::add(const Game& g, AsyncPlayer& p1, AsyncPlayer& p2,
+                        unsigned seed, GameRecord* record)
+{
+    m_impl->add(g, p1, p2, seed, record);
+}
+
+void GameScheduler::run()
+{
+    m_impl->run();
+}
+
+void GameScheduler::launch(const Game& g, AsyncPlayer& p1, AsyncPlayer& p2,
+                           unsigned seed, GameRecord* record,
+                           function<void()> over)
+{
+    m_impl->launch(g, p1, p2, seed, record, over);
+}
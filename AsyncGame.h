@@ -0,0 +1,88 @@
+#ifndef ASYNCGAME_INCLUDED
+#define ASYNCGAME_INCLUDED
+
+#include "globals.h"
+#include <functional>
+#include <string>
+
+class Board;
+class Game;
+class Player;
+struct GameRecord;
+class GameSchedulerImpl;
+
+  // A player that may answer later.  Each request hands over a callback
+  // that the player calls exactly once, from any thread, when its answer is
+  // ready; the game waiting on it is suspended until then, leaving the
+  // thread free for other games.  A game makes one request at a time, and
+  // never calls a player's other functions while one of its requests is
+  // outstanding.
+class AsyncPlayer
+{
+  public:
+    virtual ~AsyncPlayer() {}
+    virtual std::string name() const = 0;
+    virtual void recordOpponent(std::string /* nm */) {}
+      // The board must stay as it is until done is called
+    virtual void requestPlacement(Board& b, std::function<void(bool)> done) = 0;
+    virtual void requestAttack(std::function<void(Point)> done) = 0;
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
+                                    bool shipDestroyed, int shipId) = 0;
+    virtual void recordAttackByOpponent(Point p) = 0;
+};
+
+  // An ordinary Player seen as an AsyncPlayer that always answers at once
+class SyncPlayerAdapter : public AsyncPlayer
+{
+  public:
+      // The adapter deletes the player when it goes away
+    explicit SyncPlayerAdapter(Player* p);
+    virtual ~SyncPlayerAdapter();
+    virtual std::string name() const;
+    virtual void recordOpponent(std::string nm);
+    virtual void requestPlacement(Board& b, std::function<void(bool)> done);
+    virtual void requestAttack(std::function<void(Point)> done);
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
+                                    bool shipDestroyed, int shipId);
+    virtual void recordAttackByOpponent(Point p);
+      // We prevent a SyncPlayerAdapter object from being copied or assigned
+    SyncPlayerAdapter(const SyncPlayerAdapter&) = delete;
+    SyncPlayerAdapter& operator=(const SyncPlayerAdapter&) = delete;
+
+  private:
+    Player* m_player;
+};
+
+  // Plays any number of games between AsyncPlayers on a few threads.  A
+  // game runs until it has to wait for a player, then gives its thread to
+  // whichever game is ready next.  Each game keeps its own random stream,
+  // started from its seed, and carries it from thread to thread, so a game
+  // between players that answer at once goes shot for shot the same as
+  // through simulateGame from that seed, however the games interleave.
+class GameScheduler
+{
+  public:
+    explicit GameScheduler(int nThreads);
+      // Every game must be over by now
+    ~GameScheduler();
+      // Queue a game.  g, the players and record must outlive run; record,
+      // if not null, gets the game's seed, layouts, shots and winner (1 or
+      // 2, or 0 if a fleet couldn't be placed).
+    void add(const Game& g, AsyncPlayer& p1, AsyncPlayer& p2, unsigned seed,
+             GameRecord* record = nullptr);
+      // Play every queued game to its end, and wait for any launched ones
+    void run();
+      // Start a game at once, even while run is going.  over, if not empty,
+      // is called from the game's thread once it ends and record is filled
+      // in; after that the scheduler no longer touches the players.
+    void launch(const Game& g, AsyncPlayer& p1, AsyncPlayer& p2,
+                unsigned seed, GameRecord* record, std::function<void()> over);
+      // We prevent a GameScheduler object from being copied or assigned
+    GameScheduler(const GameScheduler&) = delete;
+    GameScheduler& operator=(const GameScheduler&) = delete;
+
+  private:
+    GameSchedulerImpl* m_impl;
+};
+
+#endif // ASYNCGAME_INCLUDED
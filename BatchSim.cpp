@@ -0,0 +1,340 @@
+#include "BatchSim.h"
+#include "Board.h"
+#include "Game.h"
+#include "Player.h"
+#include "Shape.h"
+#include "globals.h"
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+enum BatchType { AWFUL, RANDOM, PARITY, NBATCHTYPES };
+
+static const char* const batchTypes[NBATCHTYPES] = { "awful", "random", "parity" };
+
+vector<string> batchPlayerTypes()
+{
+    return vector<string>(batchTypes, batchTypes + NBATCHTYPES);
+}
+
+static int batchTypeIndex(const string& type)
+{
+    int k;
+    for (k = 0; k < NBATCHTYPES  &&  type != batchTypes[k]; k++)
+        ;
+    return k;
+}
+
+BatchSpec::BatchSpec()
+ : rows(10), cols(10), fleet(standardFleet()), type1("random"), type2("parity"),
+   nGames(100000), nThreads(1), lanes(1024), firstSeed(1)
+{}
+
+//******************** BatchResult *************************************
+
+void BatchResult::add(int winner, bool type1First, int winnerShots)
+{
+    m_games++;
+    if (winner != 1  &&  winner != 2)
+    {
+        m_unfinished++;
+        return;
+    }
+    if ((winner == 1) == type1First)
+        m_type1Wins++;
+    else
+        m_type2Wins++;
+    m_shotsToWin.add(winnerShots);
+}
+
+void BatchResult::merge(const BatchResult& other)
+{
+    m_games += other.m_games;
+    m_type1Wins += other.m_type1Wins;
+    m_type2Wins += other.m_type2Wins;
+    m_unfinished += other.m_unfinished;
+    m_shotsToWin.merge(other.m_shotsToWin);
+}
+
+void BatchResult::print(ostream& out, string type1, string type2) const
+{
+    double decided = m_games - m_unfinished;
+    out << "Games: " << m_games << " (" << m_unfinished << " unfinished)" << endl;
+    out << "The " << type1 << " player won " << m_type1Wins << " ("
+        << (decided > 0 ? 100 * m_type1Wins / decided : 0) << "%)" << endl;
+    out << "The " << type2 << " player won " << m_type2Wins << " ("
+        << (decided > 0 ? 100 * m_type2Wins / decided : 0) << "%)" << endl;
+    if (m_shotsToWin.count() > 0)
+        out << "Shots to win: mean " << m_shotsToWin.mean() << " +/- "
+            << m_shotsToWin.confidence() << endl;
+}
+
+//******************** LaneGroup ***************************************
+
+const int MAXPLACEMENTTRIES = 1000;
+
+  // Place a fleet at random, falling back to the first spot that fits on a
+  // crowded board
+static bool placeAtRandom(const Game& g, Board& b)
+{
+    for (int k = 0; k < g.nShips(); k++)
+    {
+        int nOrientations = g.shipShape(k).nOrientations();
+        bool placed = false;
+        for (int t = 0; t < MAXPLACEMENTTRIES  &&  !placed; t++)
+        {
+            Point p = g.randomPoint();
+            placed = b.placeShip(p, k, randInt(nOrientations));
+        }
+        for (int cell = 0; cell < g.rows() * g.cols()  &&  !placed; cell++)
+            for (int o = 0; o < nOrientations  &&  !placed; o++)
+                placed = b.placeShip(Point(cell / g.cols(), cell % g.cols()), k, o);
+        if (!placed)
+            return false;
+    }
+    return true;
+}
+
+static void shuffleCells(vector<unsigned char>& cells, int from, int to)
+{
+    for (int k = to - 1; k > from; k--)
+        swap(cells[k], cells[from + randInt(k - from + 1)]);
+}
+
+  // A group of games played in lockstep.  Cells are numbered r*cols + c.
+  // Each array holds one entry per game for each cell, ship or turn, the
+  // games' entries side by side, so a turn walks each array straight
+  // through.  Side 0 is the player moving first in every game of the group.
+class LaneGroup
+{
+  public:
+    LaneGroup(const Game& g, int lanes);
+      // Empty every board, before setting the group's games up
+    void clear();
+      // Set lane up as a game between the given batch types, placing both
+      // fleets and fixing both players' shots from the random stream
+      // started at seed
+    void setUp(int lane, const int types[2], unsigned seed);
+      // Play the first nLanes games to the end
+    void play(int nLanes);
+    int winner(int lane) const { return m_winner[lane]; }
+    int shots(int lane, int side) const { return m_shots[side][lane]; }
+
+  private:
+    const Game& m_game;
+    int m_lanes;
+    int m_cells;
+    Board m_board;      // where a fleet is placed before it's copied in
+      // The awful player's fleet is always in the same place, so it's
+      // placed once, on its own board
+    Board m_awfulBoard;
+    bool m_awfulPlaced;
+    vector<unsigned char> m_ship[2];    // [cell*lanes + lane]: 1 + id of the ship there on side's board, or 0
+    vector<unsigned char> m_afloat[2];  // [ship*lanes + lane]: that ship's cells not yet hit
+    vector<unsigned char> m_fleet[2];   // [lane]: ships of side's fleet not yet sunk
+    vector<unsigned char> m_order[2];   // [turn*lanes + lane]: the cell side shoots that turn
+    vector<unsigned char> m_live;       // [lane]: 1 while the game is going
+    vector<unsigned char> m_winner;     // [lane]: 1 or 2, or 0 if none
+    vector<unsigned short> m_shots[2];  // [lane]
+    vector<unsigned char> m_cellList;
+};
+
+LaneGroup::LaneGroup(const Game& g, int lanes)
+ : m_game(g), m_lanes(lanes), m_cells(g.rows() * g.cols()), m_board(g),
+   m_awfulBoard(g), m_live(lanes, 0), m_winner(lanes, 0), m_cellList(m_cells)
+{
+    unique_ptr<Player> awful(createPlayer("awful", "awful", g));
+    m_awfulPlaced = awful->placeShips(m_awfulBoard);
+    for (int side = 0; side < 2; side++)
+    {
+        m_ship[side].assign(m_cells * lanes, 0);
+        m_afloat[side].assign(g.nShips() * lanes, 0);
+        m_fleet[side].assign(lanes, 0);
+        m_order[side].assign(m_cells * lanes, 0);
+        m_shots[side].assign(lanes, 0);
+    }
+}
+
+void LaneGroup::clear()
+{
+    for (int side = 0; side < 2; side++)
+        fill(m_ship[side].begin(), m_ship[side].end(), 0);
+}
+
+void LaneGroup::setUp(int lane, const int types[2], unsigned seed)
+{
+      // Only the random players draw on the stream
+    if (types[0] != AWFUL  ||  types[1] != AWFUL)
+        seedRandInt(seed);
+    m_live[lane] = 0;
+    m_winner[lane] = 0;
+    for (int side = 0; side < 2; side++)
+    {
+        m_shots[side][lane] = 0;
+        m_fleet[side][lane] = 0;
+    }
+
+      // As in Game::play, a fleet that can't be placed leaves the game
+      // unfinished without the other being placed
+    for (int side = 0; side < 2; side++)
+    {
+        const Board* b = &m_awfulBoard;
+        if (types[side] != AWFUL)
+        {
+            m_board.clear();
+            if (!placeAtRandom(m_game, m_board))
+                return;
+            b = &m_board;
+        }
+        else if (!m_awfulPlaced)
+            return;
+        for (int k = 0; k < m_game.nShips(); k++)
+        {
+            Point p;
+            int o;
+            b->shipPlacement(k, p, o);
+            const vector<Point>& cells = m_game.shipShape(k).cells(o);
+            for (size_t i = 0; i < cells.size(); i++)
+            {
+                int cell = (p.r + cells[i].r) * m_game.cols() + p.c + cells[i].c;
+                m_ship[side][cell*m_lanes + lane] = k + 1;
+            }
+            m_afloat[side][k*m_lanes + lane] = cells.size();
+        }
+        m_fleet[side][lane] = m_game.nShips();
+    }
+
+    for (int side = 0; side < 2; side++)
+    {
+        if (types[side] == AWFUL)
+        {
+              // The awful player sweeps back from the bottom right corner
+            for (int t = 0; t < m_cells; t++)
+                m_cellList[t] = m_cells - 1 - t;
+        }
+        else
+        {
+            int nFirst = 0;
+            for (int cell = 0; cell < m_cells; cell++)
+            {
+                bool first = (types[side] == RANDOM  ||
+                              (cell / m_game.cols() + cell % m_game.cols()) % 2 == 0);
+                if (first)
+                    m_cellList[nFirst++] = cell;
+            }
+            int k = nFirst;
+            for (int cell = 0; cell < m_cells; cell++)
+            {
+                if (types[side] == PARITY  &&
+                    (cell / m_game.cols() + cell % m_game.cols()) % 2 != 0)
+                    m_cellList[k++] = cell;
+            }
+            shuffleCells(m_cellList, 0, nFirst);
+            shuffleCells(m_cellList, nFirst, m_cells);
+        }
+        for (int t = 0; t < m_cells; t++)
+            m_order[side][t*m_lanes + lane] = m_cellList[t];
+    }
+    m_live[lane] = 1;
+}
+
+void LaneGroup::play(int nLanes)
+{
+    int live = 0;
+    for (int lane = 0; lane < nLanes; lane++)
+        live += m_live[lane];
+
+      // No player shoots a cell twice, so every game is over within m_cells
+      // turns each and no shot needs checking against earlier ones
+    for (int t = 0; t < m_cells  &&  live > 0; t++)
+    {
+        for (int side = 0; side < 2; side++)
+        {
+            const unsigned char* order = &m_order[side][t * m_lanes];
+            const unsigned char* ship = m_ship[1-side].data();
+            unsigned char* afloat = m_afloat[1-side].data();
+            unsigned char* fleet = m_fleet[1-side].data();
+            unsigned short* shots = m_shots[side].data();
+            unsigned char* liveLane = m_live.data();
+            for (int lane = 0; lane < nLanes; lane++)
+            {
+                int on = liveLane[lane];
+                shots[lane] += on;
+                int s = ship[order[lane] * m_lanes + lane] & -on;
+                if (s == 0)
+                    continue;
+                if (--afloat[(s-1) * m_lanes + lane] == 0  &&  --fleet[lane] == 0)
+                {
+                    liveLane[lane] = 0;
+                    m_winner[lane] = side + 1;
+                    live--;
+                }
+            }
+        }
+    }
+}
+
+//******************** runBatch ****************************************
+
+bool runBatch(const BatchSpec& spec, BatchResult& result)
+{
+    result = BatchResult();
+    int type1 = batchTypeIndex(spec.type1);
+    int type2 = batchTypeIndex(spec.type2);
+    if (type1 == NBATCHTYPES  ||  type2 == NBATCHTYPES  ||  spec.lanes < 1  ||
+        spec.rows < 1  ||  spec.rows > MAXROWS  ||  spec.cols < 1  ||
+        spec.cols > MAXCOLS  ||  spec.fleet.empty())
+        return false;
+    {
+        Game g(spec.rows, spec.cols);
+        if (!addFleet(g, spec.fleet))
+            return false;
+    }
+
+    atomic<int> next(0);
+    mutex resultMutex;
+    auto worker = [&]()
+    {
+        Game g(spec.rows, spec.cols);
+        addFleet(g, spec.fleet);
+        LaneGroup group(g, spec.lanes);
+        BatchResult partial;
+        for (int start = next.fetch_add(spec.lanes); start < spec.nGames;
+                                            start = next.fetch_add(spec.lanes))
+        {
+            int n = min(spec.lanes, spec.nGames - start);
+            group.clear();
+            for (int lane = 0; lane < n; lane++)
+            {
+                int k = start + lane;
+                int types[2] = { type1, type2 };
+                if (k % 2 != 0)
+                    swap(types[0], types[1]);
+                group.setUp(lane, types, spec.firstSeed + k);
+            }
+            group.play(n);
+            for (int lane = 0; lane < n; lane++)
+            {
+                int w = group.winner(lane);
+                partial.add(w, (start + lane) % 2 == 0,
+                            w != 0 ? group.shots(lane, w - 1) : 0);
+            }
+        }
+        lock_guard<mutex> lk(resultMutex);
+        result.merge(partial);
+    };
+    vector<thread> threads;
+    for (int t = 1; t < spec.nThreads; t++)
+        threads.push_back(thread(worker));
+    worker();
+    for (size_t t = 0; t < threads.size(); t++)
+        threads[t].join();
+    return true;
+}
@@ -0,0 +1,69 @@
+#ifndef BATCHSIM_INCLUDED
+#define BATCHSIM_INCLUDED
+
+#include "Match.h"
+#include "Stats.h"
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+  // The player types the batch engine plays.  Their shots never depend on
+  // what earlier shots found, so each game's whole sequence of shots is
+  // known once its fleets are placed, and many games can advance together:
+  //   awful    as the awful player: ships stacked from the top left, shots
+  //            sweeping back from the bottom right
+  //   random   ships placed at random, shots at random cells, never twice
+  //   parity   ships placed at random, shots at random cells of one colour
+  //            of a checkerboard first and then at the rest, so every ship
+  //            longer than one cell is hit in the first half
+std::vector<std::string> batchPlayerTypes();
+
+  // What a batch run plays.  Game k starts its random stream from
+  // firstSeed+k, and type1 moves first in the even-numbered games, as in
+  // runMatch.  lanes is how many games advance in lockstep on one thread.
+struct BatchSpec
+{
+    BatchSpec();    // 100000 games of random against parity, standard fleet
+    int rows;
+    int cols;
+    std::vector<ShipSpec> fleet;
+    std::string type1;
+    std::string type2;
+    int nGames;
+    int nThreads;
+    int lanes;
+    unsigned firstSeed;
+};
+
+class BatchResult
+{
+  public:
+    BatchResult() : m_games(0), m_type1Wins(0), m_type2Wins(0), m_unfinished(0) {}
+    void add(int winner, bool type1First, int winnerShots);
+    void merge(const BatchResult& other);
+    long long games() const { return m_games; }
+    long long type1Wins() const { return m_type1Wins; }
+    long long type2Wins() const { return m_type2Wins; }
+    long long unfinished() const { return m_unfinished; }
+    const RunningMoments& shotsToWin() const { return m_shotsToWin; }
+    void print(std::ostream& out, std::string type1, std::string type2) const;
+
+  private:
+    long long m_games;
+    long long m_type1Wins;
+    long long m_type2Wins;
+    long long m_unfinished;
+    RunningMoments m_shotsToWin;
+};
+
+  // Play spec.nGames games, spec.lanes at a time on each of spec.nThreads
+  // threads, with no output.  A group of games is stored as a structure of
+  // arrays, each cell's and each ship's entry for every game of the group
+  // side by side, so a turn is one pass per player over the group that
+  // resolves that turn's shot in every game still going; ships are counted
+  // down, not searched, to find sinks.  An awful player's games end exactly
+  // as they would in Game::play.  Returns false if a type isn't a batch
+  // player type or the board or fleet is unusable.
+bool runBatch(const BatchSpec& spec, BatchResult& result);
+
+#endif // BATCHSIM_INCLUDED
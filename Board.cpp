@@ -1,6 +1,7 @@
 #include "Board.h"
 #include "Game.h"
 #include "globals.h"
+#include "Shape.h"
 #include <iostream>
 #include<vector>
 
@@ -11,55 +12,66 @@ class BoardImpl
   public:
     BoardImpl(const Game& g);
     void clear();
-    void block();
+    void block(double fraction);
     void unblock();
-    bool placeShip(Point topOrLeft, int shipId, Direction dir);
-    bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
+    bool placeShip(Point topOrLeft, int shipId, int orientation);
+    bool unplaceShip(Point topOrLeft, int shipId, int orientation);
     void display(bool shotsOnly) const;
     bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
+    int attackBatch(const vector<Point>& shots, vector<AttackResult>& results);
     bool allShipsDestroyed() const;
+    bool shipPlacement(int shipId, Point& topOrLeft, int& orientation) const;
+    bool shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const;
+    bool wasAttacked(Point p) const;
+    bool isBlocked(Point p) const;
 
   private:
+    int shipAt(int cell) const;
     const Game& m_game;
-    char board[MAXROWS][MAXCOLS]; //the actual 10x10 board game
-    //2d array of bools
-    vector <char> placed; //this keeps track of whether the ship has been placed yet
-    vector <int> destroyed; //this keeps track of the ships completely destroyed
+    //the board is kept as sets of cells, so placing a ship, checking for overlaps and checking for a sink
+    //are each a few word-wide operations whatever the ship's shape
+    CellMask inside; //the cells of the board
+    CellMask blocked; //cells no ship may be placed on
+    CellMask occupied; //cells covered by a ship
+    CellMask shot; //cells that have been attacked
+    vector <CellMask> shipCells; //the cells each ship covers, empty if it hasn't been placed
+    vector <bool> placed; //this keeps track of whether each ship has been placed yet
+    vector <Point> placedAt; //where each ship went, so a game can be recorded
+    vector <int> placedOrientation;
+    int destroyed = 0; //how many ships have been completely destroyed
 };
 
 BoardImpl::BoardImpl(const Game& g)
- : m_game(g)
+ : m_game(g), inside(boardMask(g.rows(), g.cols())), shipCells(g.nShips()),
+   placed(g.nShips(), false), placedAt(g.nShips()), placedOrientation(g.nShips(), HORIZONTAL)
 {
-    for (int i=0; i<g.rows(); i++)
-    {
-        for (int j=0; j<g.cols(); j++)
-        {
-            board[i][j] = '.';
-        }
-    }
 }
 
 void BoardImpl::clear()
 {
-    for (int i=0; i<m_game.rows(); i++)
+    blocked.reset();
+    occupied.reset();
+    shot.reset();
+    for (int k=0; k<(int)shipCells.size(); k++)
     {
-        for (int j=0; j<m_game.cols(); j++)
-        {
-            board[i][j] = '.';
-        }
+        shipCells[k].reset();
+        placed[k] = false;
     }
+    destroyed = 0;
 }
 
-void BoardImpl::block()
+void BoardImpl::block(double fraction)
 {
-      // Block cells with 50% probability
-    int numCells = m_game.rows()*m_game.cols()/2;
+      // Block that fraction of the cells, chosen at random
+    int numCells = int(m_game.rows()*m_game.cols()*fraction);
+    if (numCells > m_game.rows()*m_game.cols())
+        numCells = m_game.rows()*m_game.cols();
     for (int i=0; i<numCells; i++)
     {
         Point p = m_game.randomPoint();
-        if (board[p.r][p.c] != 'b')
+        if (!blocked.test(cellIndex(p)))
         {
-            board[p.r][p.c] = 'b'; //blocks cell at Point p
+            blocked.set(cellIndex(p)); //blocks cell at Point p
         }
         else{
             i--;
@@ -69,145 +81,73 @@ void BoardImpl::block()
 
 void BoardImpl::unblock()
 {
-    for (int r = 0; r < m_game.rows(); r++)
-        for (int c = 0; c < m_game.cols(); c++)
-        {
-            if (board[r][c] == 'b')
-            {
-                board[r][c] = '.'; //unblocks cell (r,c) if blocked
-            }
-        }
+    blocked.reset();
 }
 
-bool BoardImpl::placeShip(Point topOrLeft, int shipId, Direction dir)
+//the ship covering a cell, or -1 if it's water
+int BoardImpl::shipAt(int cell) const
 {
-    if (shipId < 0 || shipId >= m_game.nShips()) //validating shipId
-    {
-        return false;
-    }
-    
-    int length = m_game.shipLength(shipId);
-    char symbol = m_game.shipSymbol(shipId);
-    
-    //first check whether that ship has already been placed
-    for (int i=0; i<placed.size(); i++)
+    for (int k=0; k<(int)shipCells.size(); k++)
     {
-        if (placed[i] == symbol)
+        if (shipCells[k].test(cell))
         {
-            return false;
+            return k;
         }
     }
-    
-    int r1 =0;
-    int c1 =0;
-    
-    if (dir == VERTICAL)
+    return -1;
+}
+
+bool BoardImpl::placeShip(Point topOrLeft, int shipId, int orientation)
+{
+    if (shipId < 0 || shipId >= m_game.nShips()) //validating shipId
     {
-        if (topOrLeft.r+length <= m_game.rows()) // ship is fully inside the board
-        {
-            for (int r=topOrLeft.r; r < topOrLeft.r+length; r++)
-            {
-                if (board[r][topOrLeft.c] != '.')
-                {
-                    return false; //overlaps already placed ship or is blocked
-                }
-                r1 = r;
-            }
-        }
-        else{
-            return false; //doesn't fit inside the board
-        }
+        return false;
     }
-    else // dir is horizontal
+    if (placed[shipId]) //first check whether that ship has already been placed
     {
-        if (topOrLeft.c+length <= m_game.cols()) // ship is fully inside the board
-        {
-            for (int c=topOrLeft.c; c < topOrLeft.c+length; c++)
-            {
-                if (board[topOrLeft.r][c] != '.')
-                {
-                    return false; //overlaps already placed ship or is blocked
-                }
-                c1 = c;
-            }
-        }
-        else{
-            return false; //doesn't fit inside the board
-        }
+        return false;
     }
     
-    if (r1 == topOrLeft.r+length-1) //if every condition was satisfied for placing the ship vertically, this statement would be true
+    const ShipShape& shape = m_game.shipShape(shipId);
+    if (!shape.fits(orientation, topOrLeft, m_game.rows(), m_game.cols()))
     {
-        for (int k=topOrLeft.r; k < topOrLeft.r+length; k++)
-        {
-            board[k][topOrLeft.c] = symbol;
-        }
+        return false; //doesn't fit inside the board
     }
-    else if (c1 == topOrLeft.c+length-1) //if every condition was satisfied for placing the ship horizontally, this statement would be true
+    CellMask cells = shape.maskAt(orientation, topOrLeft);
+    if ((cells & (occupied | blocked | shot)).any())
     {
-        for (int k=topOrLeft.c; k<topOrLeft.c+length; k++)
-        {
-            board[topOrLeft.r][k] = symbol;
-        }
+        return false; //overlaps already placed ship or is blocked
     }
     
-    placed.push_back(symbol);
+    occupied |= cells;
+    shipCells[shipId] = cells;
+    placed[shipId] = true;
+    placedAt[shipId] = topOrLeft;
+    placedOrientation[shipId] = orientation;
     return true;
 }
 
-bool BoardImpl::unplaceShip(Point topOrLeft, int shipId, Direction dir)
+bool BoardImpl::unplaceShip(Point topOrLeft, int shipId, int orientation)
 {
     if (shipId < 0 || shipId >= m_game.nShips()) //validating shipId
     {
         return false;
     }
     
-    int length = m_game.shipLength(shipId);
-    char symbol = m_game.shipSymbol(shipId);
-    
-    if (dir == VERTICAL)
-    {
-        for (int k=topOrLeft.r; k < topOrLeft.r+length; k++)
-        {
-            if (board[k][topOrLeft.c] != symbol) //if the board does not contain the entire ship at the indicated locations
-            {
-                return false;
-            }
-        }
-        for (int k=topOrLeft.r; k < topOrLeft.r+length; k++)
-        {
-            //if conditions are valid, update the board
-            board[k][topOrLeft.c] = '.';
-        }
-    }
-    else // dir is horizontal
+    const ShipShape& shape = m_game.shipShape(shipId);
+    if (!placed[shipId] || !shape.fits(orientation, topOrLeft, m_game.rows(), m_game.cols()))
     {
-        for (int k=topOrLeft.c; k < topOrLeft.c+length; k++)
-        {
-            if (board[topOrLeft.r][k] != symbol) //if the board does not contain the entire ship at the indicated locations
-            {
-                return false;
-            }
-        }
-        for (int k=topOrLeft.c; k < topOrLeft.c+length; k++)
-        {
-            //if conditions are valid, update the board
-            board[topOrLeft.r][k] = '.';
-        }
+        return false;
     }
-    
-    //remove the symbol from the vector placed because that ship was unplaced
-    int i;
-    for (i=0; i<placed.size(); i++)
+    CellMask cells = shape.maskAt(orientation, topOrLeft);
+    if (cells != shipCells[shipId] || (cells & shot).any()) //if the board does not contain the entire, undamaged ship at the indicated locations
     {
-        if (placed[i] == symbol)
-        {
-            break;
-        }
+        return false;
     }
     
-    placed.erase(placed.begin()+i);
-    
+    occupied &= ~cells;
+    shipCells[shipId].reset();
+    placed[shipId] = false;
     return true;
 }
 
@@ -227,19 +167,22 @@ void BoardImpl::display(bool shotsOnly) const
         
         for (int j=0; j<m_game.cols(); j++)
         {
-            if (board[i][j]=='.' || board[i][j]=='o'|| board[i][j]=='X')
+            int cell = cellIndex(Point(i, j));
+            if (shot.test(cell))
             {
-                cout << board[i][j];
+                cout << (occupied.test(cell) ? 'X' : 'o');
             }
-            else // if the char is a symbol
+            else if (shotsOnly)
             {
-                if (shotsOnly)
-                {
-                    cout << '.';
-                }
-                else{
-                    cout << board[i][j];
-                }
+                cout << '.';
+            }
+            else if (occupied.test(cell))
+            {
+                cout << m_game.shipSymbol(shipAt(cell));
+            }
+            else
+            {
+                cout << (blocked.test(cell) ? 'b' : '.');
             }
         }
         
@@ -249,73 +192,120 @@ void BoardImpl::display(bool shotsOnly) const
 
 bool BoardImpl::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
 {
-    if (!m_game.isValid(p) || board[p.r][p.c] == 'o' || board[p.r][p.c] == 'X') //checks validity of Point p
+    if (!m_game.isValid(p) || shot.test(cellIndex(p))) //checks validity of Point p
     {
         return false;
     }
     
-    shotHit = false; //shotHit will be false unless the attack is validated later
-    
-    char symbol = board[p.r][p.c]; // the symbol point to be attacked
-    if (board[p.r][p.c] != '.') //if Point p has a ship
+    int cell = cellIndex(p);
+    shot.set(cell);
+    shotHit = occupied.test(cell);
+    if (!shotHit)
     {
-        shotHit = true;
-        board[p.r][p.c] = 'X';
+        //a miss has always reported destroyed when it took the last untouched water cell; players rely on
+        //what shipDestroyed says after a miss, so that stays as it was
+        shipDestroyed = (inside & ~occupied & ~blocked & ~shot).none();
+        return true;
     }
-    else // if there is no ship there
+    
+    //this attack destroyed the ship if none of the ship's cells is left unshot
+    int k = shipAt(cell);
+    shipDestroyed = (shipCells[k] & ~shot).none();
+    if (shipDestroyed)
     {
-        board[p.r][p.c] = 'o';
+        shipId = k;
+        destroyed++;
     }
     
-    //checks if this specific attack destroyed the last undamaged segment of a ship
-    bool check = false;
-    for (int i=0; i<m_game.rows(); i++)
+    return true;
+}
+
+int BoardImpl::attackBatch(const vector<Point>& shots, vector<AttackResult>& results)
+{
+    results.resize(shots.size());
+    vector<int> shipHit(shots.size(), -1);
+    for (int i=0; i<(int)shots.size(); i++)
     {
-        for (int j=0; j<m_game.cols(); j++)
+        AttackResult& r = results[i];
+        Point p = shots[i];
+        r.p = p;
+        r.shotHit = false;
+        r.shipDestroyed = false;
+        r.shipId = 0;
+        r.valid = m_game.isValid(p) && !shot.test(cellIndex(p));
+        if (!r.valid)
         {
-            if (board[i][j] == symbol)
-            {
-                check = true; //check becomes true if segment(s) still remain
-            }
+            continue;
+        }
+        shot.set(cellIndex(p));
+        if (occupied.test(cellIndex(p)))
+        {
+            r.shotHit = true;
+            shipHit[i] = shipAt(cellIndex(p));
         }
-    }
-    bool remains = false;
-    if (check) //if segments still remain, variable remain becomes true
-    {
-        remains = true;
     }
     
-    if (remains) //attack was not on the last undamaged segment of a ship
-    {
-        shipDestroyed = false;
-    }
-    else //attack destroyed the last undamaged segment of a ship
+    //the last shot to hit a sunk ship is the one that sank it
+    int sunk = 0;
+    vector<bool> reported(m_game.nShips(), false);
+    for (int i=(int)shots.size()-1; i>=0; i--)
     {
-        shipDestroyed = true;
-        //now determine the shipId of the ship the was destroyed
-        for (int k=0; k<m_game.nShips(); k++)
+        int k = shipHit[i];
+        if (k < 0 || reported[k] || (shipCells[k] & ~shot).any())
         {
-            if (m_game.shipSymbol(k) == symbol) //iterate thru the vector of ship symbols until we hit the element with the matching symbol. When that is found, set the shipId to the index & break out of the loop.
-            {
-                shipId = k;
-                destroyed.push_back(shipId);
-                break;
-            }
+            continue;
         }
+        reported[k] = true; //so earlier hits on it don't count it again
+        results[i].shipDestroyed = true;
+        results[i].shipId = k;
+        destroyed++;
+        sunk++;
     }
-    
-    return true;
+    return sunk;
 }
 
 bool BoardImpl::allShipsDestroyed() const
 {
-    if (destroyed.size() == m_game.nShips()) //the vector destroyed will be filled with nShips if all nShips are destroyed
+    if (destroyed == m_game.nShips()) //destroyed will reach nShips once all nShips are destroyed
     {
         return true;
     }
     return false;
 }
 
+bool BoardImpl::shipPlacement(int shipId, Point& topOrLeft, int& orientation) const
+{
+    if (shipId < 0 || shipId >= m_game.nShips() || !placed[shipId]) //validating shipId, and that ship has been placed
+    {
+        return false;
+    }
+    
+    topOrLeft = placedAt[shipId];
+    orientation = placedOrientation[shipId];
+    return true;
+}
+
+bool BoardImpl::shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const
+{
+    int orientation = HORIZONTAL;
+    if (!shipPlacement(shipId, topOrLeft, orientation) || !m_game.shipShape(shipId).isStraight()) //a shaped ship has no Direction
+    {
+        return false;
+    }
+    dir = (orientation == VERTICAL ? VERTICAL : HORIZONTAL);
+    return true;
+}
+
+bool BoardImpl::wasAttacked(Point p) const
+{
+    return m_game.isValid(p) && shot.test(cellIndex(p));
+}
+
+bool BoardImpl::isBlocked(Point p) const
+{
+    return m_game.isValid(p) && blocked.test(cellIndex(p));
+}
+
 //******************** Board functions ********************************
 
 // These functions simply delegate to BoardImpl's functions.
@@ -338,7 +328,12 @@ void Board::clear()
 
 void Board::block()
 {
-    return m_impl->block();
+    return m_impl->block(0.5);
+}
+
+void Board::block(double fraction)
+{
+    return m_impl->block(fraction);
 }
 
 void Board::unblock()
@@ -346,14 +341,14 @@ void Board::unblock()
     return m_impl->unblock();
 }
 
-bool Board::placeShip(Point topOrLeft, int shipId, Direction dir)
+bool Board::placeShip(Point topOrLeft, int shipId, int orientation)
 {
-    return m_impl->placeShip(topOrLeft, shipId, dir);
+    return m_impl->placeShip(topOrLeft, shipId, orientation);
 }
 
-bool Board::unplaceShip(Point topOrLeft, int shipId, Direction dir)
+bool Board::unplaceShip(Point topOrLeft, int shipId, int orientation)
 {
-    return m_impl->unplaceShip(topOrLeft, shipId, dir);
+    return m_impl->unplaceShip(topOrLeft, shipId, orientation);
 }
 
 void Board::display(bool shotsOnly) const
@@ -366,7 +361,32 @@ bool Board::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
     return m_impl->attack(p, shotHit, shipDestroyed, shipId);
 }
 
+int Board::attackBatch(const vector<Point>& shots, vector<AttackResult>& results)
+{
+    return m_impl->attackBatch(shots, results);
+}
+
 bool Board::allShipsDestroyed() const
 {
     return m_impl->allShipsDestroyed();
 }
+
+bool Board::shipPlacement(int shipId, Point& topOrLeft, int& orientation) const
+{
+    return m_impl->shipPlacement(shipId, topOrLeft, orientation);
+}
+
+bool Board::shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const
+{
+    return m_impl->shipPlacement(shipId, topOrLeft, dir);
+}
+
+bool Board::wasAttacked(Point p) const
+{
+    return m_impl->wasAttacked(p);
+}
+
+bool Board::isBlocked(Point p) const
+{
+    return m_impl->isBlocked(p);
+}
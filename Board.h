@@ -2,10 +2,21 @@
 #define BOARD_INCLUDED
 
 #include "globals.h"
+#include <vector>
 
 class Game;
 class BoardImpl;
 
+  // What one shot of a salvo did
+struct AttackResult
+{
+    Point p;
+    bool valid;
+    bool shotHit;
+    bool shipDestroyed;
+    int shipId;         // the ship destroyed, if shipDestroyed
+};
+
 class Board
 {
   public:
@@ -13,12 +24,29 @@ class Board
     ~Board();
     void clear();
     void block();
+    void block(double fraction);
     void unblock();
-    bool placeShip(Point topOrLeft, int shipId, Direction dir);
-    bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
+      // orientation is one of the ship's ShipShape orientations, which for
+      // a straight ship is a Direction; topOrLeft is where the top left
+      // corner of that orientation's bounding box goes
+    bool placeShip(Point topOrLeft, int shipId, int orientation);
+    bool unplaceShip(Point topOrLeft, int shipId, int orientation);
     void display(bool shotsOnly) const;
     bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
+      // Fire every shot at once, in order, so a shot repeating an earlier
+      // one is invalid, and fill results with one entry per shot.  A ship
+      // sunk by the salvo is reported once, by the last shot that hit it.
+      // Returns how many ships the salvo sank.
+    int attackBatch(const std::vector<Point>& shots,
+                    std::vector<AttackResult>& results);
     bool allShipsDestroyed() const;
+    bool shipPlacement(int shipId, Point& topOrLeft, int& orientation) const;
+      // As above, but false for a ship that isn't straight
+    bool shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const;
+      // Whether p has been attacked, and whether it's blocked; false for a
+      // point off the board
+    bool wasAttacked(Point p) const;
+    bool isBlocked(Point p) const;
       // We prevent a Board object from being copied or assigned
     Board(const Board&) = delete;
     Board& operator=(const Board&) = delete;
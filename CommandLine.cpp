@@ -0,0 +1,254 @@
+#include "CommandLine.h"
+#include "Match.h"
+#include "Player.h"
+#include "Stats.h"
+#include "GameRecord.h"
+#include "GameServer.h"
+#include "EnginePlayer.h"
+#include "OpeningBook.h"
+#include "OpponentModel.h"
+#include "Shape.h"
+#include "globals.h"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include <signal.h>
+
+using namespace std;
+
+  // Quote s as a JSON string
+static string jsonString(const string& s)
+{
+    string out = "\"";
+    for (size_t k = 0; k < s.size(); k++)
+    {
+        unsigned char ch = s[k];
+        if (ch == '"'  ||  ch == '\\')
+        {
+            out += '\\';
+            out += ch;
+        }
+        else if (ch < 0x20)
+        {
+            static const char hex[] = "0123456789abcdef";
+            out += "\\u00";
+            out += hex[ch >> 4];
+            out += hex[ch & 0xf];
+        }
+        else
+            out += ch;
+    }
+    return out + "\"";
+}
+
+static bool parseInt(const char* text, long long low, long long high, long long& n)
+{
+    char* end;
+    n = strtoll(text, &end, 10);
+    return *text != '\0'  &&  *end == '\0'  &&  n >= low  &&  n <= high;
+}
+
+static bool parseDouble(const char* text, double low, double high, double& x)
+{
+    char* end;
+    x = strtod(text, &end);
+    return *text != '\0'  &&  *end == '\0'  &&  x >= low  &&  x <= high;
+}
+
+  // Lengths separated by commas, made into ships with distinct symbols;
+  // an item with a '/' in it is the picture of a shaped ship
+static bool parseFleet(const string& text, vector<ShipSpec>& fleet)
+{
+    fleet.clear();
+    istringstream in(text);
+    string item;
+    char symbol = 'A';
+    while (getline(in, item, ','))
+    {
+        long long length;
+        ShipShape shape;
+        if (item.find('/') != string::npos)
+        {
+            if (!ShipShape::fromPicture(item, shape))
+                return false;
+            fleet.push_back(ShipSpec(item, symbol, string("ship ") + symbol));
+        }
+        else if (parseInt(item.c_str(), 1, max(MAXROWS, MAXCOLS), length))
+            fleet.push_back(ShipSpec(length, symbol, string("ship ") + symbol));
+        else
+            return false;
+        symbol++;
+    }
+    return !fleet.empty()  &&  fleet.size() <= 26;
+}
+
+static string gameLine(int k, const GameRecord& record, bool type1First,
+                       const MatchSpec& spec)
+{
+    int shots[2] = { 0, 0 };
+    int wasted = 0;
+    for (size_t i = 0; i < record.shots.size(); i++)
+    {
+        shots[record.shots[i].player]++;
+        wasted += !record.shots[i].valid;
+    }
+    ostringstream line;
+    line << "{\"game\":" << k << ",\"seed\":" << record.seed
+         << ",\"first\":" << jsonString(type1First ? spec.type1 : spec.type2)
+         << ",\"second\":" << jsonString(type1First ? spec.type2 : spec.type1)
+         << ",\"winner\":" << record.winner
+         << ",\"shots\":[" << shots[0] << "," << shots[1] << "]"
+         << ",\"wasted\":" << wasted << "}\n";
+    return line.str();
+}
+
+  // Serve until SIGINT or SIGTERM
+static int serve(string path, int nThreads)
+{
+      // Blocked before any thread starts, so only the waiter below sees them
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+
+    GameServer server;
+    if (!server.open(path, nThreads))
+    {
+        cerr << "Can't listen on " << path << endl;
+        return 1;
+    }
+    thread waiter([&]()
+    {
+        int sig;
+        sigwait(&stopSignals, &sig);
+        server.stop();
+    });
+    server.serve();
+    waiter.join();
+    cerr << "Served " << server.gamesPlayed() << " games" << endl;
+    return 0;
+}
+
+static int usage(string problem)
+{
+    cerr << problem << endl
+         << "usage: battleship [--type1 T] [--type2 T] [--rows N] [--cols N]"
+         << " [--fleet L,L,...]" << endl
+         << "                  [--games N] [--seed S] [--threads N] [--paired]"
+         << " [--book FILE]" << endl
+         << "                  [--models FILE] [--move-time S]"
+         << " [--placement-threads N]" << endl
+         << "       battleship --serve PATH [--threads N]" << endl
+         << "       battleship --engine T" << endl;
+    return 2;
+}
+
+int runCommandLine(int argc, char* argv[])
+{
+    MatchSpec spec;
+    spec.nGames = 1;
+    string servePath;
+    OpponentModels models;
+    string modelsFile;
+    for (int k = 1; k < argc; k++)
+    {
+        string option = argv[k];
+        if (option == "--paired")
+        {
+            spec.paired = true;
+            continue;
+        }
+        if (k + 1 == argc)
+            return usage(option + " needs a value");
+        const char* value = argv[++k];
+        long long n = 0;
+        double x = 0;
+        if (option == "--engine")
+            return runEngine(value);
+        else if (option == "--serve")
+            servePath = value;
+        else if (option == "--type1")
+            spec.type1 = value;
+        else if (option == "--type2")
+            spec.type2 = value;
+        else if (option == "--fleet")
+        {
+            if (!parseFleet(value, spec.fleet))
+                return usage(string("bad fleet ") + value);
+        }
+        else if (option == "--book")
+        {
+            if (!loadOpeningBook(value))
+                return usage(string("can't load the opening book ") + value);
+        }
+        else if (option == "--models")
+        {
+              // A file that isn't there yet is where a first run saves them
+            if (ifstream(value)  &&  !models.load(value))
+                return usage(string("can't load the opponent profiles ") + value);
+            modelsFile = value;
+            spec.models = &models;
+        }
+        else if (option == "--rows"  &&  parseInt(value, 1, MAXROWS, n))
+            spec.rows = n;
+        else if (option == "--cols"  &&  parseInt(value, 1, MAXCOLS, n))
+            spec.cols = n;
+        else if (option == "--games"  &&  parseInt(value, 1, 1000000000, n))
+            spec.nGames = n;
+        else if (option == "--seed"  &&  parseInt(value, 0, 4294967295LL, n))
+            spec.firstSeed = n;
+        else if (option == "--threads"  &&  parseInt(value, 1, 1024, n))
+            spec.nThreads = n;
+        else if (option == "--move-time"  &&  parseDouble(value, 1e-9, 1e6, x))
+            spec.timeControl.moveSeconds = x;
+        else if (option == "--placement-threads"  &&  parseInt(value, 1, 1024, n))
+            setPlacementThreads(n);
+        else
+            return usage("bad option " + option + " " + value);
+    }
+    if (!servePath.empty())
+        return serve(servePath, spec.nThreads);
+
+      // Lines go out whole, in the order games end
+    ios::sync_with_stdio(false);
+    mutex outMutex;
+    GameCallback onGame = [&](int k, const GameRecord& record, bool type1First)
+    {
+        string line = gameLine(k, record, type1First, spec);
+        lock_guard<mutex> lk(outMutex);
+        cout << line << flush;
+    };
+    StatsAggregator stats;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    if (!runMatch(spec, stats, nullptr, onGame))
+    {
+        cerr << "The match can't be set up: check the board, fleet and"
+             << " player types" << endl;
+        return 1;
+    }
+    if (!modelsFile.empty()  &&  !models.save(modelsFile))
+    {
+        cerr << "Can't save the opponent profiles to " << modelsFile << endl;
+        return 1;
+    }
+    GameStats total = stats.total();
+    cout << "{\"summary\":true,\"type1\":" << jsonString(spec.type1)
+         << ",\"type2\":" << jsonString(spec.type2)
+         << ",\"games\":" << total.games()
+         << ",\"type1Wins\":" << total.type1Wins()
+         << ",\"type2Wins\":" << total.type2Wins()
+         << ",\"unfinished\":"
+         << total.games() - total.type1Wins() - total.type2Wins()
+         << ",\"seconds\":" << chrono::duration<double>(
+                                chrono::steady_clock::now() - start).count()
+         << "}" << endl;
+    return 0;
+}
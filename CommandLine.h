@@ -0,0 +1,33 @@
+#ifndef COMMANDLINE_INCLUDED
+#define COMMANDLINE_INCLUDED
+
+  // Run the program non-interactively as its arguments say, for scripts:
+  //   --type1 T --type2 T   the player types (default mediocre and good)
+  //   --rows N --cols N     the board (default 10 by 10)
+  //   --fleet L,L,...       ship lengths (default the standard fleet), or
+  //                         pictures of shaped ships such as XXX/.X.
+  //   --games N             how many games (default 1)
+  //   --seed S              game k starts its random stream from S+k
+  //                         (default 1)
+  //   --threads N           how many games at once (default 1); a match
+  //                         with a type that learns across games plays
+  //                         them one at a time whatever N is
+  //   --paired              play each seed twice with the layouts swapped,
+  //                         as N/2 pairs (an odd N drops the last game)
+  //   --book FILE           let good players use an opening book
+  //   --models FILE         start from the opponent profiles in FILE, if it
+  //                         exists, and save them there after the match
+  //   --move-time S         allow each player S seconds a move, after which
+  //                         its shot goes to a random cell (default no limit)
+  //   --placement-threads N let each mediocre player try N placements at
+  //                         once (default 1); the layouts don't change
+  // Each game is written to standard output as one line of JSON when it
+  // ends, and a last line sums the run up.  Instead of a match, it can
+  //   --serve PATH          host a GameServer on a Unix socket until
+  //                         interrupted, playing on --threads threads
+  //   --engine T            act as an external engine for player type T
+  // Returns the process's exit status: 0 on success, 1 if the run couldn't
+  // be set up, 2 if the arguments make no sense.
+int runCommandLine(int argc, char* argv[]);
+
+#endif // COMMANDLINE_INCLUDED
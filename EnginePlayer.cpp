@@ -0,0 +1,457 @@
+#include "EnginePlayer.h"
+#include "Player.h"
+#include "Board.h"
+#include "Game.h"
+#include "Shape.h"
+#include "globals.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+  // How long a quitting engine gets to exit before it's killed
+const int ENGINE_EXIT_MS = 100;
+
+//******************** EnginePlayer ************************************
+
+class EnginePlayer : public Player
+{
+  public:
+    EnginePlayer(string nm, const Game& g);
+    virtual ~EnginePlayer();
+    bool launch(string command);
+    virtual void recordOpponent(string nm);
+    virtual bool placeShips(Board& b);
+    virtual Point recommendAttack();
+    virtual void recommendAttacks(int k, vector<Point>& shots);
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
+                                    bool shipDestroyed, int shipId);
+    virtual void recordAttackByOpponent(Point p);
+    virtual void recordSubstitutedShot(Point asked, Point fired);
+
+  private:
+      // Queue a line that needs no answer
+    void post(const string& line);
+      // Send everything queued, then line, and wait for the answer
+    bool ask(const string& line, string& answer);
+    bool flush();
+    bool readLine(string& line, double seconds);
+    void drop();
+    Point randomShot() const;
+    pid_t m_pid;
+    int m_toEngine;
+    int m_fromEngine;
+    string m_out;
+    string m_in;
+    int m_stale;            // answers still owed to questions given up on
+    vector<bool> m_shotAt;
+};
+
+EnginePlayer::EnginePlayer(string nm, const Game& g)
+ : Player(nm, g), m_pid(-1), m_toEngine(-1), m_fromEngine(-1), m_stale(0),
+   m_shotAt(g.rows() * g.cols(), false)
+{}
+
+EnginePlayer::~EnginePlayer()
+{
+    if (m_pid > 0)
+    {
+        post("quit");
+        flush();
+    }
+    drop();
+}
+
+bool EnginePlayer::launch(string command)
+{
+      // A write to an engine that has died must fail rather than kill us
+    struct sigaction old;
+    if (sigaction(SIGPIPE, nullptr, &old) == 0  &&  old.sa_handler == SIG_DFL)
+        signal(SIGPIPE, SIG_IGN);
+
+    int toEngine[2];
+    int fromEngine[2];
+    if (pipe2(toEngine, O_CLOEXEC) < 0)
+        return false;
+    if (pipe2(fromEngine, O_CLOEXEC) < 0)
+    {
+        close(toEngine[0]);
+        close(toEngine[1]);
+        return false;
+    }
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+          // Only async-signal-safe calls until exec
+        dup2(toEngine[0], STDIN_FILENO);
+        dup2(fromEngine[1], STDOUT_FILENO);
+        execl("/bin/sh", "sh", "-c", command.c_str(), (char*)nullptr);
+        _exit(127);
+    }
+    close(toEngine[0]);
+    close(fromEngine[1]);
+    if (pid < 0)
+    {
+        close(toEngine[1]);
+        close(fromEngine[0]);
+        return false;
+    }
+    m_pid = pid;
+    m_toEngine = toEngine[1];
+    m_fromEngine = fromEngine[0];
+
+    const Game& g = game();
+    ostringstream line;
+    line << "game " << g.rows() << " " << g.cols();
+    for (int k = 0; k < g.nShips(); k++)
+        line << " " << g.shipLength(k);
+    post(line.str());
+    return true;
+}
+
+void EnginePlayer::drop()
+{
+    if (m_toEngine >= 0)
+        close(m_toEngine);
+    if (m_fromEngine >= 0)
+        close(m_fromEngine);
+    m_toEngine = -1;
+    m_fromEngine = -1;
+    m_out.clear();
+    if (m_pid <= 0)
+        return;
+    for (int waited = 0; waitpid(m_pid, nullptr, WNOHANG) == 0; waited++)
+    {
+        if (waited == ENGINE_EXIT_MS)
+        {
+            kill(m_pid, SIGKILL);
+            waitpid(m_pid, nullptr, 0);
+            break;
+        }
+        usleep(1000);
+    }
+    m_pid = -1;
+}
+
+void EnginePlayer::post(const string& line)
+{
+    if (m_pid > 0)
+    {
+        m_out += line;
+        m_out += '\n';
+    }
+}
+
+bool EnginePlayer::flush()
+{
+    size_t sent = 0;
+    while (sent < m_out.size())
+    {
+        ssize_t n = write(m_toEngine, m_out.data() + sent, m_out.size() - sent);
+        if (n < 0  &&  errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        sent += n;
+    }
+    m_out.clear();
+    return true;
+}
+
+  // False if nothing came in time, or the engine is gone
+bool EnginePlayer::readLine(string& line, double seconds)
+{
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::now() +
+        chrono::duration_cast<chrono::steady_clock::duration>(
+                                            chrono::duration<double>(seconds));
+    size_t nl;
+    while ((nl = m_in.find('\n')) == string::npos)
+    {
+        double left = chrono::duration<double>(deadline -
+                                               chrono::steady_clock::now()).count();
+        pollfd pfd;
+        pfd.fd = m_fromEngine;
+        pfd.events = POLLIN;
+        int ready = poll(&pfd, 1, max(0, (int)ceil(left * 1000)));
+        if (ready < 0  &&  errno == EINTR)
+            continue;
+        if (ready <= 0)
+            return false;
+        char buf[4096];
+        ssize_t n = read(m_fromEngine, buf, sizeof(buf));
+        if (n < 0  &&  errno == EINTR)
+            continue;
+        if (n <= 0)
+        {
+            drop();
+            return false;
+        }
+        m_in.append(buf, n);
+    }
+    line = m_in.substr(0, nl);
+    m_in.erase(0, nl + 1);
+    return true;
+}
+
+bool EnginePlayer::ask(const string& line, string& answer)
+{
+    if (m_pid <= 0)
+        return false;
+    post(line);
+    if (!flush())
+    {
+        drop();
+        return false;
+    }
+    double wait = min(ENGINE_TIMEOUT, max(0.0, timeLeft()));
+    for (;;)
+    {
+        if (!readLine(answer, wait))
+        {
+            if (m_pid > 0  &&  wait < ENGINE_TIMEOUT)
+                m_stale++;      // out of time, but the answer may yet come
+            else
+                drop();
+            return false;
+        }
+        if (m_stale == 0)
+            return true;
+        m_stale--;
+    }
+}
+
+Point EnginePlayer::randomShot() const
+{
+    vector<int> open;
+    for (size_t k = 0; k < m_shotAt.size(); k++)
+        if (!m_shotAt[k])
+            open.push_back(k);
+    if (open.empty())
+        return Point(0, 0);
+    int k = open[randInt(open.size())];
+    return Point(k / game().cols(), k % game().cols());
+}
+
+void EnginePlayer::recordOpponent(string nm)
+{
+    post("opponent " + nm);
+}
+
+bool EnginePlayer::placeShips(Board& b)
+{
+    m_shotAt.assign(m_shotAt.size(), false);
+    string answer;
+    if (!ask("place", answer))
+        return false;
+    istringstream in(answer);
+    string word;
+    in >> word;
+    if (word != "layout")
+        return false;
+    vector<Point> placed;
+    vector<Direction> dirs;
+    for (int k = 0; k < game().nShips(); k++)
+    {
+        Point p;
+        char dir = 0;
+        bool ok = (in >> p.r >> p.c >> dir)  &&  (dir == 'h'  ||  dir == 'v');
+        Direction d = (dir == 'h' ? HORIZONTAL : VERTICAL);
+        if (!ok  ||  !b.placeShip(p, k, d))
+        {
+            for (size_t j = 0; j < placed.size(); j++)
+                b.unplaceShip(placed[j], j, dirs[j]);
+            return false;
+        }
+        placed.push_back(p);
+        dirs.push_back(d);
+    }
+    return true;
+}
+
+Point EnginePlayer::recommendAttack()
+{
+    string answer;
+    Point p(-1, -1);
+    if (ask("attack", answer))
+    {
+        istringstream in(answer);
+        if (!(in >> p.r >> p.c))
+            p = Point(-1, -1);
+    }
+    if (!game().isValid(p)  ||  m_shotAt[p.r * game().cols() + p.c])
+        p = randomShot();
+    m_shotAt[p.r * game().cols() + p.c] = true;
+    return p;
+}
+
+void EnginePlayer::recommendAttacks(int k, vector<Point>& shots)
+{
+    shots.clear();
+    string answer;
+    bool answered = ask("volley " + to_string(k), answer);
+    istringstream in(answer);
+    for (int i = 0; i < k; i++)
+    {
+        Point p(-1, -1);
+        if (!answered  ||  !(in >> p.r >> p.c))
+            p = Point(-1, -1);
+        if (!game().isValid(p)  ||  m_shotAt[p.r * game().cols() + p.c])
+            p = randomShot();
+        m_shotAt[p.r * game().cols() + p.c] = true;
+        shots.push_back(p);
+    }
+}
+
+void EnginePlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
+                                      bool shipDestroyed, int shipId)
+{
+    ostringstream line;
+    line << "result " << p.r << " " << p.c << " " << validShot << " "
+         << shotHit << " " << shipDestroyed << " " << shipId;
+    post(line.str());
+}
+
+void EnginePlayer::recordSubstitutedShot(Point asked, Point fired)
+{
+    if (game().isValid(asked))
+        m_shotAt[asked.r * game().cols() + asked.c] = false;
+    m_shotAt[fired.r * game().cols() + fired.c] = true;
+    ostringstream line;
+    line << "substituted " << asked.r << " " << asked.c << " " << fired.r
+         << " " << fired.c;
+    post(line.str());
+}
+
+void EnginePlayer::recordAttackByOpponent(Point p)
+{
+    post("incoming " + to_string(p.r) + " " + to_string(p.c));
+}
+
+Player* createEnginePlayer(string command, string nm, const Game& g)
+{
+    if (hasShapedShips(g))
+        return nullptr;
+    EnginePlayer* p = new EnginePlayer(nm, g);
+    if (!p->launch(command))
+    {
+        delete p;
+        return nullptr;
+    }
+    return p;
+}
+
+//******************** runEngine ***************************************
+
+int runEngine(string type)
+{
+    ios::sync_with_stdio(false);
+    unique_ptr<Game> g;
+    unique_ptr<Player> player;
+    unique_ptr<Board> board;
+    string line;
+    while (getline(cin, line))
+    {
+        istringstream in(line);
+        string word;
+        in >> word;
+        if (word == "game"  &&  g == nullptr)
+        {
+            int rows;
+            int cols;
+            int length;
+            if (!(in >> rows >> cols)  ||  rows < 1  ||  rows > MAXROWS  ||
+                cols < 1  ||  cols > MAXCOLS)
+                return 1;
+            g.reset(new Game(rows, cols));
+            for (char symbol = 'A'; in >> length; symbol++)
+                if (!g->addShip(length, symbol, string("ship ") + symbol))
+                    return 1;
+            player.reset(createPlayer(type, type + " engine", *g));
+            if (player == nullptr  ||  player->isHuman())
+                return 1;
+        }
+        else if (player == nullptr)
+            return 1;
+        else if (word == "opponent")
+        {
+            string nm;
+            getline(in >> ws, nm);
+            player->recordOpponent(nm);
+        }
+        else if (word == "place")
+        {
+            board.reset(new Board(*g));
+            if (!player->placeShips(*board))
+                cout << "none" << endl;
+            else
+            {
+                cout << "layout";
+                for (int k = 0; k < g->nShips(); k++)
+                {
+                    Point p;
+                    Direction dir;
+                    board->shipPlacement(k, p, dir);
+                    cout << " " << p.r << " " << p.c
+                         << (dir == HORIZONTAL ? " h" : " v");
+                }
+                cout << endl;
+            }
+        }
+        else if (word == "attack")
+        {
+            Point p = player->recommendAttack();
+            cout << p.r << " " << p.c << endl;
+        }
+        else if (word == "volley")
+        {
+            int k = 0;
+            in >> k;
+            vector<Point> shots;
+            player->recommendAttacks(k, shots);
+            for (size_t i = 0; i < shots.size(); i++)
+                cout << (i == 0 ? "" : " ") << shots[i].r << " " << shots[i].c;
+            cout << endl;
+        }
+        else if (word == "result")
+        {
+            Point p;
+            bool valid;
+            bool hit;
+            bool destroyed;
+            int shipId;
+            if (in >> p.r >> p.c >> valid >> hit >> destroyed >> shipId)
+                player->recordAttackResult(p, valid, hit, destroyed, shipId);
+        }
+        else if (word == "substituted")
+        {
+            Point asked;
+            Point fired;
+            if (in >> asked.r >> asked.c >> fired.r >> fired.c)
+                player->recordSubstitutedShot(asked, fired);
+        }
+        else if (word == "incoming")
+        {
+            Point p;
+            if (in >> p.r >> p.c)
+                player->recordAttackByOpponent(p);
+        }
+        else if (word == "quit")
+            break;
+    }
+      // The player may refer to the game, so it goes first
+    board.reset();
+    player.reset();
+    return 0;
+}
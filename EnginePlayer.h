@@ -0,0 +1,46 @@
+#ifndef ENGINEPLAYER_INCLUDED
+#define ENGINEPLAYER_INCLUDED
+
+#include <string>
+
+class Player;
+class Game;
+
+  // createPlayer treats a type starting with this as an external engine:
+  // the rest of the type is a shell command that starts it
+const char* const ENGINE_PREFIX = "engine:";
+
+  // A player whose moves come from a separate program.  The program reads
+  // lines on its standard input and answers some of them on its standard
+  // output:
+  //   game <rows> <cols> <length> ...   once, first; ship ids are in order
+  //   opponent <name>                   before each game
+  //   place        answer "layout <r> <c> <h|v> ..." in ship id order, or
+  //                "none" if the fleet can't be placed
+  //   attack       answer "<r> <c>"
+  //   volley <k>   answer "<r> <c> ..." with k shots, for a salvo
+  //   result <r> <c> <valid> <hit> <destroyed> <shipId>   of its last shot
+  //   substituted <r> <c> <r> <c>       its shot at the first cell was
+  //                late, and the second was shot instead; its result follows
+  //   incoming <r> <c>                  the opponent's shot
+  //   quit
+  // Lines needing no answer wait and go out with the next question, so a
+  // move costs one write and one read each way.  An engine that says
+  // nothing for ENGINE_TIMEOUT seconds, or exits, is dropped, and the
+  // player carries on with random shots so the game still ends; under a
+  // time control the player stops waiting when the clock runs out and
+  // ignores that answer when it comes.  An attack that's missing, off the
+  // board or repeats a shot is replaced by a random new one, so a confused
+  // engine can't stall a game.  Returns nullptr if the program can't be
+  // started, or if a ship of g's fleet isn't straight, since the protocol
+  // only has lengths and directions.
+Player* createEnginePlayer(std::string command, std::string nm, const Game& g);
+
+const double ENGINE_TIMEOUT = 10;
+
+  // The other end: serve the built-in computer player type over standard
+  // input and output until told to quit.  Returns 0, or 1 if type isn't a
+  // computer player type or the game it's given is unusable.
+int runEngine(std::string type);
+
+#endif // ENGINEPLAYER_INCLUDED
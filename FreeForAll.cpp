@@ -0,0 +1,313 @@
+#include "FreeForAll.h"
+#include "Board.h"
+#include "Game.h"
+#include "OpponentModel.h"
+#include "Player.h"
+#include "globals.h"
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//******************** playFreeForAll **********************************
+
+static string seatName(int seat, const string& type)
+{
+    return type + " (seat " + to_string(seat + 1) + ")";
+}
+
+  // The seats still in the game: a ring for whose turn is next, and a
+  // packed list for handing out targets, each updated in constant time
+class Table
+{
+  public:
+    Table(int n)
+     : m_next(n), m_prev(n), m_index(n)
+    {
+        for (int s = 0; s < n; s++)
+        {
+            m_next[s] = (s + 1) % n;
+            m_prev[s] = (s + n - 1) % n;
+            m_index[s] = s;
+            m_seats.push_back(s);
+        }
+    }
+    int size() const { return m_seats.size(); }
+    bool in(int seat) const { return m_index[seat] >= 0; }
+    int next(int seat) const { return m_next[seat]; }
+    const vector<int>& seats() const { return m_seats; }
+    void remove(int seat)
+    {
+        m_next[m_prev[seat]] = m_next[seat];
+        m_prev[m_next[seat]] = m_prev[seat];
+        int i = m_index[seat];
+        m_seats[i] = m_seats.back();
+        m_index[m_seats[i]] = i;
+        m_seats.pop_back();
+        m_index[seat] = -1;
+    }
+
+  private:
+    vector<int> m_next;
+    vector<int> m_prev;
+    vector<int> m_index;    // where each seat is in m_seats, or -1 if it's out
+    vector<int> m_seats;
+};
+
+bool playFreeForAll(const Game& g, const vector<string>& types, unsigned seed,
+                    int firstSeat, FreeForAllRecord& record,
+                    OpponentModels* models)
+{
+    int n = types.size();
+    if (n < 2)
+        return false;
+    record = FreeForAllRecord();
+    record.seed = seed;
+    seedRandInt(seed);
+
+      // Unless the caller carries it between games, what the players learn
+      // about each other stays in this game
+    OpponentModels own;
+    if (models == nullptr)
+        models = &own;
+    vector<unique_ptr<Player>> placers(n);
+    for (int s = 0; s < n; s++)
+    {
+        placers[s].reset(createPlayer(types[s], seatName(s, types[s]), g));
+        if (placers[s] == nullptr  ||  placers[s]->isHuman())
+            return false;
+        placers[s]->setOpponentModels(models);
+    }
+
+      // A seat that can't place its fleet is out before the first shot
+    Table table(n);
+    vector<unique_ptr<Board>> boards(n);
+    vector<int> shipsLeft(n, g.nShips());
+    vector<int> shotsTaken(n, 0);
+    for (int s = 0; s < n; s++)
+    {
+        boards[s].reset(new Board(g));
+        if (!placers[s]->placeShips(*boards[s]))
+        {
+            table.remove(s);
+            record.knockedOut.push_back(s);
+        }
+    }
+
+      // attackers[s*n + t] hunts seat t's board for seat s
+    vector<unique_ptr<Player>> attackers(n * n);
+    vector<TargetInfo> targets;
+    targets.reserve(n);
+      // Enough for every seat to shoot every cell of every board twice, so
+      // a player that keeps wasting shots can't stall the game
+    long long maxShots = 2LL * n * n * g.rows() * g.cols();
+    int s = firstSeat % n;
+    if (table.size() > 0  &&  !table.in(s))
+        s = table.seats()[0];
+    while (table.size() > 1  &&  record.shots < maxShots)
+    {
+        targets.clear();
+        const vector<int>& seats = table.seats();
+        for (size_t i = 0; i < seats.size(); i++)
+        {
+            if (seats[i] == s)
+                continue;
+            TargetInfo info;
+            info.seat = seats[i];
+            info.shipsLeft = shipsLeft[seats[i]];
+            info.shotsTaken = shotsTaken[seats[i]];
+            targets.push_back(info);
+        }
+        int pick = placers[s]->chooseTarget(targets);
+        int t = targets[pick >= 0  &&  pick < (int)targets.size() ? pick : 0].seat;
+
+        unique_ptr<Player>& attacker = attackers[s*n + t];
+        if (attacker == nullptr)
+        {
+            attacker.reset(createPlayer(types[s], seatName(s, types[s]), g));
+            attacker->setOpponentModels(models);
+            attacker->recordOpponent(seatName(t, types[t]));
+        }
+        Point p = attacker->recommendAttack();
+        bool shotHit = false;
+        bool shipDestroyed = false;
+        int shipId = 100;
+        bool validShot = boards[t]->attack(p, shotHit, shipDestroyed, shipId);
+        record.shots++;
+        shotsTaken[t]++;
+        if (validShot)
+        {
+            attacker->recordAttackResult(p, true, shotHit, shipDestroyed, shipId);
+            placers[t]->recordAttackByOpponent(p);
+            if (shotHit  &&  shipDestroyed)
+                shipsLeft[t]--;
+            if (boards[t]->allShipsDestroyed())
+            {
+                table.remove(t);
+                record.knockedOut.push_back(t);
+            }
+        }
+        s = table.next(s);
+    }
+    if (table.size() == 1)
+        record.winner = table.seats()[0];
+    return true;
+}
+
+//******************** FreeForAllResult ********************************
+
+FreeForAllSpec::FreeForAllSpec()
+ : rows(10), cols(10), fleet(standardFleet()), nGames(200), nThreads(1),
+   firstSeed(1), models(nullptr)
+{
+    vector<string> all = playerTypes();
+    vector<string> computers;
+    Game g(rows, cols);
+    addFleet(g, fleet);
+    for (size_t k = 0; k < all.size(); k++)
+        if (isComputerType(all[k], g))
+            computers.push_back(all[k]);
+    for (int s = 0; s < 16; s++)
+        types.push_back(computers[s % computers.size()]);
+}
+
+void FreeForAllResult::start(const FreeForAllSpec& spec)
+{
+    m_types = spec.types;
+    m_wins.assign(m_types.size(), 0);
+    m_placeSum.assign(m_types.size(), 0);
+    m_games = 0;
+    m_unfinished = 0;
+    m_shots = 0;
+}
+
+void FreeForAllResult::add(const FreeForAllRecord& record)
+{
+    int n = m_types.size();
+    m_games++;
+    m_shots += record.shots;
+    if (record.winner < 0)
+        m_unfinished++;
+    else
+    {
+        m_wins[record.winner]++;
+        m_placeSum[record.winner] += 1;
+    }
+      // The first seat out finishes last; seats left in an unfinished game
+      // share the places above the ones knocked out
+    vector<bool> out(n, false);
+    for (size_t i = 0; i < record.knockedOut.size(); i++)
+    {
+        m_placeSum[record.knockedOut[i]] += n - i;
+        out[record.knockedOut[i]] = true;
+    }
+    if (record.winner < 0)
+    {
+        int left = n - record.knockedOut.size();
+        for (int s = 0; s < n; s++)
+            if (!out[s])
+                m_placeSum[s] += (1 + left) / 2.0;
+    }
+}
+
+void FreeForAllResult::merge(const FreeForAllResult& other)
+{
+    m_games += other.m_games;
+    m_unfinished += other.m_unfinished;
+    m_shots += other.m_shots;
+    for (size_t s = 0; s < m_wins.size(); s++)
+    {
+        m_wins[s] += other.m_wins[s];
+        m_placeSum[s] += other.m_placeSum[s];
+    }
+}
+
+double FreeForAllResult::meanPlace(int seat) const
+{
+    return m_games > 0 ? m_placeSum[seat] / m_games : 0;
+}
+
+void FreeForAllResult::print(ostream& out) const
+{
+    map<string, int> seats;
+    map<string, long long> wins;
+    map<string, double> placeSum;
+    for (size_t s = 0; s < m_types.size(); s++)
+    {
+        seats[m_types[s]]++;
+        wins[m_types[s]] += m_wins[s];
+        placeSum[m_types[s]] += m_placeSum[s];
+    }
+    streamsize oldPrecision = out.precision(3);
+    out << m_games << " games of " << m_types.size() << " seats ("
+        << m_unfinished << " unfinished), " << (m_games > 0 ? double(m_shots) / m_games : 0)
+        << " shots per game" << endl;
+    out << setw(12) << "type" << setw(8) << "seats" << setw(14) << "wins/seat"
+        << setw(14) << "mean place" << endl;
+    for (map<string, int>::iterator it = seats.begin(); it != seats.end(); it++)
+    {
+        out << setw(12) << it->first << setw(8) << it->second
+            << setw(14) << double(wins[it->first]) / it->second
+            << setw(14) << (m_games > 0 ? placeSum[it->first] / (m_games * it->second) : 0)
+            << endl;
+    }
+    out.precision(oldPrecision);
+}
+
+//******************** runFreeForAll ***********************************
+
+bool runFreeForAll(const FreeForAllSpec& spec, FreeForAllResult& result)
+{
+    result.start(spec);
+    if (spec.types.size() < 2  ||  spec.rows < 1  ||  spec.rows > MAXROWS  ||
+        spec.cols < 1  ||  spec.cols > MAXCOLS  ||  spec.fleet.empty())
+        return false;
+    bool learns = false;
+    {
+        Game g(spec.rows, spec.cols);
+        if (!addFleet(g, spec.fleet))
+            return false;
+        for (size_t s = 0; s < spec.types.size(); s++)
+        {
+            if (!isComputerType(spec.types[s], g))
+                return false;
+            learns = learns  ||  learnsAcrossGames(spec.types[s], g);
+        }
+    }
+    OpponentModels own;
+    OpponentModels* models = (spec.models != nullptr ? spec.models : &own);
+
+    atomic<int> next(0);
+    mutex resultMutex;
+    auto worker = [&]()
+    {
+        Game g(spec.rows, spec.cols);
+        addFleet(g, spec.fleet);
+        FreeForAllResult partial;
+        partial.start(spec);
+        FreeForAllRecord record;
+        for (int k = next++; k < spec.nGames; k = next++)
+        {
+            playFreeForAll(g, spec.types, spec.firstSeed + k,
+                           k % spec.types.size(), record, models);
+            partial.add(record);
+        }
+        lock_guard<mutex> lk(resultMutex);
+        result.merge(partial);
+    };
+    vector<thread> threads;
+    for (int t = 1; t < spec.nThreads  &&  !learns; t++)
+        threads.push_back(thread(worker));
+    worker();
+    for (size_t t = 0; t < threads.size(); t++)
+        threads[t].join();
+    return true;
+}
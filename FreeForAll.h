@@ -0,0 +1,87 @@
+#ifndef FREEFORALL_INCLUDED
+#define FREEFORALL_INCLUDED
+
+#include "Match.h"
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+class Game;
+class OpponentModels;
+
+  // How one free-for-all game went
+struct FreeForAllRecord
+{
+    FreeForAllRecord() : seed(0), winner(-1), shots(0) {}
+    unsigned seed;
+    int winner;                 // the last seat left, or -1 if none was
+    std::vector<int> knockedOut;    // seats in the order they were eliminated
+    long long shots;
+};
+
+  // Play one free-for-all game with no output, one seat per entry of types
+  // (computer player types), starting this thread's random stream from
+  // seed.  Every seat places a fleet on its own board; then, going round
+  // the table from seat firstSeat, each seat still in the game picks an
+  // opponent with Player::chooseTarget and shoots at its board.  A seat
+  // whose ships are all destroyed is out, and the last one left wins.
+  //
+  // A seat is a placing player that also hears every shot at its board,
+  // plus one attacking player of its type per opponent it has shot at,
+  // made when it first picks that opponent, since the players only know
+  // how to hunt one board.  Passing the turn and knocking a seat out cost
+  // constant time however many seats there are; choosing a target is one
+  // pass over the seats still in.  The players learn from and add to
+  // models, or to a set of the game's own if it's null.  Returns false if a
+  // type is unknown or human or there are fewer than two seats.
+bool playFreeForAll(const Game& g, const std::vector<std::string>& types,
+                    unsigned seed, int firstSeat, FreeForAllRecord& record,
+                    OpponentModels* models = nullptr);
+
+  // What a batch of free-for-all games plays: game k starts from
+  // firstSeed+k with seat k mod the number of seats moving first
+struct FreeForAllSpec
+{
+    FreeForAllSpec();   // 16 seats of the computer types in turn
+    int rows;
+    int cols;
+    std::vector<ShipSpec> fleet;
+    std::vector<std::string> types;     // one per seat
+    int nGames;
+    int nThreads;
+    unsigned firstSeed;
+      // The opponent profiles the seats carry from game to game; if null,
+      // the batch keeps a set of its own, which starts empty
+    OpponentModels* models;
+};
+
+  // The totals of a batch of free-for-all games, by seat
+class FreeForAllResult
+{
+  public:
+    FreeForAllResult() : m_games(0), m_unfinished(0), m_shots(0) {}
+    void start(const FreeForAllSpec& spec);
+    void add(const FreeForAllRecord& record);
+    void merge(const FreeForAllResult& other);
+    long long games() const { return m_games; }
+    long long wins(int seat) const { return m_wins[seat]; }
+      // Mean finishing place of a seat, 1 for the winner
+    double meanPlace(int seat) const;
+      // Wins and mean place pooled over the seats of each type
+    void print(std::ostream& out) const;
+
+  private:
+    std::vector<std::string> m_types;
+    std::vector<long long> m_wins;
+    std::vector<double> m_placeSum;
+    long long m_games;
+    long long m_unfinished;
+    long long m_shots;
+};
+
+  // Play spec.nGames games on spec.nThreads threads with no output, or in
+  // seed order on this thread if a seat's type learns across games.
+  // Returns false if the games can't be set up.
+bool runFreeForAll(const FreeForAllSpec& spec, FreeForAllResult& result);
+
+#endif // FREEFORALL_INCLUDED
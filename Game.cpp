@@ -2,15 +2,22 @@
 #include "Board.h"
 #include "Player.h"
 #include "globals.h"
+#include "GameRecord.h"
+#include "TimeControl.h"
+#include "Shape.h"
 #include <iostream>
 #include <string>
 #include <cstdlib>
 #include <cctype>
 #include<vector>
 #include<algorithm>
+#include<random>
+#include<thread>
 
 using namespace std;
 
+class Speculation;
+
 class GameImpl
 {
   public:
@@ -19,27 +26,111 @@ class GameImpl
     int cols() const;
     bool isValid(Point p) const;
     Point randomPoint() const;
-    bool addShip(int length, char symbol, string name);
+    bool addShip(const ShipShape& shape, char symbol, string name);
     int nShips() const;
     int shipLength(int shipId) const;
+    const ShipShape& shipShape(int shipId) const;
     char shipSymbol(int shipId) const;
     string shipName(int shipId) const;
-    //auxiliary function to change the order in which the ships are stored in the vectors so that it's in the order of biggest ship size to lowest
-    void changeOrder();
+    void setSeed(unsigned seed);
+    void setTimeControl(const TimeControl& tc);
+    void setSpeculation(bool on);
+    void setSalvo(int shotsPerTurn);
     Player* play(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause);
+    const GameRecord& lastRecord() const;
 private:
+    bool timedAttack(Player* attacker, MoveClock& clock, bool timed, vector<bool>& shotAt, Speculation& spec, Point& p);
+    Player* playSalvo(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause, MoveClock& clock1, MoveClock& clock2, bool timed1, bool timed2);
     int mrows;
     int mcols;
     int numShips = 0;
-    bool changed = false;
-    //these vectors store the length, symbol, and name of the 5 ships for each player
+    //these vectors store the length (cell count), shape, symbol, and name of the ships, ordered from biggest ship size to lowest
     vector <int> lengths;
+    vector <ShipShape> shapes;
     vector <char> symbols;
     vector <string> names;
-    vector <int> newLengths;
-    vector <char> newSymbols;
-    vector <string> newNames;
+    bool hasSeed = false; //if false, each game starts from a fresh random seed
+    unsigned nextSeed = 0;
+    GameRecord record; //what happened in the most recent game
+    TimeControl timeControl; //no limits unless setTimeControl is called
+    bool speculate = false; //work out a computer's reply while a person is choosing their shot
+    int salvo = 0; //shots per turn in salvo mode, SALVO_SURVIVING_SHIPS, or 0 for the classic game
+};
 
+//A computer player's next attack, worked out on another thread while a person chooses theirs.
+//The worker carries on this thread's random stream and hands it back, so the game goes exactly as if
+//the attack had been asked for in turn.
+class Speculation
+{
+  public:
+    ~Speculation();
+    void start(Player* p);
+    void finish(MoveClock& clock); //wait for the attack, charging the wait to the player's clock
+    bool take(Point& p, bool& late); //the finished attack, once
+  private:
+    thread m_worker;
+    mt19937 m_engine;
+    Point m_attack;
+    bool m_running = false;
+    bool m_ready = false;
+    bool m_late = false;
+};
+
+Speculation::~Speculation()
+{
+    if (m_running)
+    {
+        m_worker.join(); //the game ended first; the attack is thrown away
+    }
+}
+
+void Speculation::start(Player* p)
+{
+    m_engine = randomEngine();
+    m_running = true;
+    m_ready = false;
+    m_worker = thread([this, p]()
+    {
+        randomEngine() = m_engine;
+        m_attack = p->recommendAttack();
+        m_engine = randomEngine();
+    });
+}
+
+void Speculation::finish(MoveClock& clock)
+{
+    if (!m_running)
+    {
+        return;
+    }
+    clock.startMove();
+    m_worker.join();
+    m_late = clock.stopMove();
+    randomEngine() = m_engine;
+    m_running = false;
+    m_ready = true;
+}
+
+bool Speculation::take(Point& p, bool& late)
+{
+    if (!m_ready)
+    {
+        return false;
+    }
+    p = m_attack;
+    late = m_late;
+    m_ready = false;
+    return true;
+}
+
+//lends a player its clock for one game and takes it back however the game ends
+class ClockLoan
+{
+  public:
+    ClockLoan(Player* p, const MoveClock* clock) : m_player(p) { m_player->setClock(clock); }
+    ~ClockLoan() { m_player->setClock(nullptr); }
+  private:
+    Player* m_player;
 };
 
 void waitForEnter()
@@ -76,8 +167,9 @@ Point GameImpl::randomPoint() const
     return Point(randInt(rows()), randInt(cols()));
 }
 
-bool GameImpl::addShip(int length, char symbol, string name)
+bool GameImpl::addShip(const ShipShape& shape, char symbol, string name)
 {
+    int length = shape.size();
     if (length <= 0)
     {
         return false;
@@ -95,9 +187,16 @@ bool GameImpl::addShip(int length, char symbol, string name)
         }
     }
     
-    lengths.push_back(length);
-    symbols.push_back(symbol);
-    names.push_back(name);
+    //keep the ships ordered from biggest to lowest, so every engine sees the same ship ids; ships of equal length stay in the order they were added
+    int pos = 0;
+    while (pos < (int)lengths.size() && lengths[pos] >= length)
+    {
+        pos++;
+    }
+    lengths.insert(lengths.begin()+pos, length);
+    shapes.insert(shapes.begin()+pos, shape);
+    symbols.insert(symbols.begin()+pos, symbol);
+    names.insert(names.begin()+pos, name);
     numShips++;
     return true;
 }
@@ -109,93 +208,156 @@ int GameImpl::nShips() const
 
 int GameImpl::shipLength(int shipId) const
 {
-    if (!changed)
-    {
-        return lengths.at(shipId);
-    }
-    else
-    {
-        return newLengths.at(shipId);
-    }
+    return lengths.at(shipId);
+}
+
+const ShipShape& GameImpl::shipShape(int shipId) const
+{
+    return shapes.at(shipId);
 }
 
 char GameImpl::shipSymbol(int shipId) const
 {
-    if (!changed)
-    {
-        return symbols.at(shipId);
-    }
-    else
-    {
-        return newSymbols.at(shipId);
-    }
+    return symbols.at(shipId);
 }
 
 string GameImpl::shipName(int shipId) const
 {
-    if (!changed)
-    {
-        return names.at(shipId);
-    }
-    else
-    {
-        return newNames.at(shipId);
-    }
+    return names.at(shipId);
+}
+
+void GameImpl::setSeed(unsigned seed)
+{
+    hasSeed = true;
+    nextSeed = seed;
 }
 
-//auxiliary function to change the order in which the ships are stored in the vectors so that it's in the order of biggest ship size to lowest
-void GameImpl::changeOrder()
+const GameRecord& GameImpl::lastRecord() const
 {
-    //temporary vector that will store length's original values
-    vector <int> temp;
-    for (int j=0; j<lengths.size(); j++)
+    return record;
+}
+
+void GameImpl::setTimeControl(const TimeControl& tc)
+{
+    timeControl = tc;
+}
+
+void GameImpl::setSpeculation(bool on)
+{
+    speculate = on;
+}
+
+void GameImpl::setSalvo(int shotsPerTurn)
+{
+    salvo = (shotsPerTurn < 0 ? SALVO_SURVIVING_SHIPS : shotsPerTurn);
+}
+
+//Ask for an attack on the attacker's clock, or take the one it worked out while its opponent was choosing.
+//Returns false if the attacker forfeits by running out of time; under the other penalty a late shot goes
+//to a random cell it hasn't shot at yet instead
+bool GameImpl::timedAttack(Player* attacker, MoveClock& clock, bool timed, vector<bool>& shotAt, Speculation& spec, Point& p)
+{
+    bool late = false;
+    if (!spec.take(p, late))
     {
-        temp.push_back(lengths[j]);
+        clock.startMove();
+        p = attacker->recommendAttack();
+        late = clock.stopMove();
     }
-    
-    //now, newLengths will get the values from lengths after it's sorted in descending order
-    sort(lengths.begin(),lengths.end(), greater<int>()); //Sorting the vector using greater<int>() function
-    for (int j=0; j<lengths.size(); j++)
+    if (!late || !timed)
     {
-        newLengths.push_back(lengths[j]);
+        return true;
+    }
+    if (timeControl.penalty == FORFEIT)
+    {
+        cout << attacker->name() << " ran out of time and forfeits." << endl;
+        return false;
     }
     
-    vector <int> newIndex;
-    
-    for (int i=0; i<newLengths.size(); i++)
+    Point asked = p;
+    int open = (int)count(shotAt.begin(), shotAt.end(), false);
+    int pick = randInt(open);
+    for (int k=0; k<(int)shotAt.size(); k++)
     {
-        int a = newLengths[i];
-        
-        for (int j=0; j<temp.size(); j++)
+        if (!shotAt[k] && pick-- == 0)
         {
-            if (a == temp[j]) //find the index where the element from newLengths is in the original vector
-            {
-                temp[j] = -1;
-                newIndex.push_back(j);
-                break; //should break out of innter for loop
-            }
+            p = Point(k / cols(), k % cols());
+            break;
         }
     }
-    //now sort the vectors of names, symbols, and shipdestroyed based on how lengths was sorted
-    for (int k=0; k<newIndex.size(); k++)
-    {
-        newNames.push_back(names[newIndex[k]]);
-        newSymbols.push_back(symbols[newIndex[k]]);
-    }
-    
-    changed = true;
+    attacker->recordSubstitutedShot(asked, p); //the cell it chose is never shot, so it mustn't count it as shot
+    cout << attacker->name() << " ran out of time, so it shoots at random." << endl;
+    return true;
 }
 
 Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause)
 {
-    changeOrder();
+    //every game starts its random stream from a recorded seed, so it can be replayed
+    record = GameRecord();
+    record.seed = (hasSeed ? nextSeed : random_device{}());
+    seedRandInt(record.seed);
+    
+    p1->recordOpponent(p2->name());
+    p2->recordOpponent(p1->name());
+    
+    //under a time control each computer player gets a clock for this game; people aren't timed
+    MoveClock clock1(timeControl);
+    MoveClock clock2(timeControl);
+    bool timed1 = timeControl.enabled() && !p1->isHuman();
+    bool timed2 = timeControl.enabled() && !p2->isHuman();
+    ClockLoan loan1(p1, timed1 ? &clock1 : nullptr);
+    ClockLoan loan2(p2, timed2 ? &clock2 : nullptr);
     
     //calls the placeShips function of each player to place the ships on their respective board
-    if (!p1->placeShips(b1) || !p2->placeShips(b2))
+    clock1.startMove();
+    bool placed = p1->placeShips(b1);
+    bool late1 = clock1.stopMove() && timed1;
+    bool late2 = false;
+    if (placed)
+    {
+        clock2.startMove();
+        placed = p2->placeShips(b2);
+        late2 = clock2.stopMove() && timed2;
+    }
+    if (!placed)
     {
         return nullptr;
     }
     
+    for (int k=0; k<nShips(); k++)
+    {
+        ShipPlacement s1;
+        ShipPlacement s2;
+        b1.shipPlacement(k, s1.topOrLeft, s1.orientation);
+        b2.shipPlacement(k, s2.topOrLeft, s2.orientation);
+        record.layouts[0].push_back(s1);
+        record.layouts[1].push_back(s2);
+    }
+    
+    //a fleet can't be placed at random after the fact, so a late placement is only punished by forfeiting
+    if ((late1 || late2) && timeControl.penalty == FORFEIT)
+    {
+        Player* loser = (late1 ? p1 : p2);
+        cout << loser->name() << " ran out of time placing ships and forfeits." << endl;
+        record.winner = (late1 ? 2 : 1);
+        return (late1 ? p2 : p1);
+    }
+    
+    if (salvo != 0)
+    {
+        return playSalvo(p1, p2, b1, b2, shouldPause, clock1, clock2, timed1, timed2);
+    }
+    
+    //the cells each board has been shot at, so a late player's random shot is never wasted
+    vector<bool> shotAt1(rows()*cols(), false);
+    vector<bool> shotAt2(rows()*cols(), false);
+    
+    //while a person chooses a shot, a computer opponent whose reply can't depend on it works that reply out
+    Speculation spec1;
+    Speculation spec2;
+    bool speculate1 = speculate && p2->isHuman() && !p1->isHuman() && p1->attackIgnoresOpponentShots();
+    bool speculate2 = speculate && p1->isHuman() && !p2->isHuman() && p2->attackIgnoresOpponentShots();
+    
     int n=0;
     int p1destroyed = 0;
     int p2destroyed = 0;
@@ -217,15 +379,29 @@ Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, bool should
                 b2.display(false);
             }
             //now we will attack
-            Point p = p1->recommendAttack();
+            Point p;
+            if (speculate2)
+            {
+                spec2.start(p2);
+            }
+            bool onTime = timedAttack(p1, clock1, timed1, shotAt2, spec1, p);
+            spec2.finish(clock2);
+            if (!onTime)
+            {
+                record.winner = 2;
+                return p2;
+            }
             bool shotHit = false;
             bool shipDestroyed = false;
             int shipId = 100;
-            if (b2.attack(p, shotHit, shipDestroyed, shipId))
+            bool validShot = b2.attack(p, shotHit, shipDestroyed, shipId);
+            record.addShot(0, p, validShot, shotHit, shipDestroyed, shipId);
+            if (validShot)
             {
+                shotAt2[p.r*cols() + p.c] = true;
                 p1->recordAttackResult(p, true, shotHit, shipDestroyed, shipId);
                 
-                p1->recordAttackByOpponent(p);
+                p2->recordAttackByOpponent(p);
                 
                 if (!shotHit)
                 {
@@ -266,6 +442,7 @@ Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, bool should
                     {
                         b1.display(false);
                     }
+                    record.winner = 1;
                     return p1;
                 }
                 else if(shouldPause)
@@ -291,14 +468,28 @@ Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, bool should
                 cout << p2->name() << "'s turn. Board for " << p1->name() << ":" << endl;
                 b1.display(false);
             }
-            Point p = p2->recommendAttack();
+            Point p;
+            if (speculate1)
+            {
+                spec1.start(p1);
+            }
+            bool onTime = timedAttack(p2, clock2, timed2, shotAt1, spec2, p);
+            spec1.finish(clock1);
+            if (!onTime)
+            {
+                record.winner = 1;
+                return p1;
+            }
             bool shotHit = false;
             bool shipDestroyed = false;
             int shipId = 100;
-            if (b1.attack(p, shotHit, shipDestroyed, shipId))
+            bool validShot = b1.attack(p, shotHit, shipDestroyed, shipId);
+            record.addShot(1, p, validShot, shotHit, shipDestroyed, shipId);
+            if (validShot)
             {
+                shotAt1[p.r*cols() + p.c] = true;
                 p2->recordAttackResult(p, true, shotHit, shipDestroyed, shipId);
-                p2->recordAttackByOpponent(p);
+                p1->recordAttackByOpponent(p);
                 
                 if (!shotHit)
                 {
@@ -339,6 +530,7 @@ Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, bool should
                     {
                         b2.display(false);
                     }
+                    record.winner = 2;
                     return p2;
                 }
                 else if(shouldPause)
@@ -356,6 +548,116 @@ Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, bool should
     return nullptr;
 }
 
+//The salvo variant of the loop above: each turn is one volley, asked for in one call and resolved in one pass.
+//A volley is one move on the clock; a late one goes to random cells or forfeits, as a late shot does.
+//Nothing is worked out ahead while a person chooses, since a person's whole volley lands at once anyway.
+Player* GameImpl::playSalvo(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause, MoveClock& clock1, MoveClock& clock2, bool timed1, bool timed2)
+{
+    Player* players[2] = { p1, p2 };
+    Board* targets[2] = { &b2, &b1 };
+    MoveClock* clocks[2] = { &clock1, &clock2 };
+    bool timed[2] = { timed1, timed2 };
+    int afloat[2] = { nShips(), nShips() }; //the ships each player has left
+    vector<bool> shotAt[2] = { vector<bool>(rows()*cols(), false), vector<bool>(rows()*cols(), false) }; //by the board shot at
+    vector<Point> shots;
+    vector<AttackResult> results;
+    
+    for (int n=0; ; n++)
+    {
+        int me = n%2;
+        Player* attacker = players[me];
+        Player* defender = players[1-me];
+        Board& target = *targets[me];
+        cout << attacker->name() << "'s turn. Board for " << defender->name() << ":" << endl;
+        target.display(attacker->isHuman());
+        
+        //a volley never needs more shots than there are cells left to shoot
+        vector<int> open;
+        for (int k=0; k<(int)shotAt[me].size(); k++)
+        {
+            if (!shotAt[me][k])
+            {
+                open.push_back(k);
+            }
+        }
+        int volley = min(salvo > 0 ? salvo : afloat[me], (int)open.size());
+        
+        clocks[me]->startMove();
+        attacker->recommendAttacks(volley, shots);
+        bool late = clocks[me]->stopMove() && timed[me];
+        if (shots.size() > (size_t)volley)
+        {
+            shots.resize(volley);
+        }
+        if (late)
+        {
+            if (timeControl.penalty == FORFEIT)
+            {
+                cout << attacker->name() << " ran out of time and forfeits." << endl;
+                record.winner = 2-me;
+                return defender;
+            }
+            vector<Point> asked;
+            asked.swap(shots);
+            for (int i=0; i<volley; i++)
+            {
+                swap(open[i], open[i + randInt(open.size() - i)]);
+                shots.push_back(Point(open[i] / cols(), open[i] % cols()));
+            }
+            for (int i=0; i<(int)asked.size(); i++)
+            {
+                attacker->recordSubstitutedShot(asked[i], shots[i]);
+            }
+            cout << attacker->name() << " ran out of time, so its salvo goes at random." << endl;
+        }
+        
+        target.attackBatch(shots, results);
+        for (size_t i=0; i<results.size(); i++)
+        {
+            const AttackResult& r = results[i];
+            record.addShot(me, r.p, r.valid, r.shotHit, r.shipDestroyed, r.shipId);
+            if (!r.valid)
+            {
+                cout << attacker->name() << " wasted a shot at (" << r.p.r << "," << r.p.c << ")." << endl;
+                continue;
+            }
+            shotAt[me][r.p.r*cols() + r.p.c] = true;
+            attacker->recordAttackResult(r.p, true, r.shotHit, r.shipDestroyed, r.shipId);
+            defender->recordAttackByOpponent(r.p);
+            if (!r.shotHit)
+            {
+                cout << attacker->name() << " attacked (" << r.p.r << "," << r.p.c << ") and missed." << endl;
+            }
+            else if (r.shipDestroyed)
+            {
+                cout << attacker->name() << " attacked (" << r.p.r << "," << r.p.c << ") and destroyed the " << shipName(r.shipId) << "." << endl;
+                afloat[1-me]--;
+            }
+            else
+            {
+                cout << attacker->name() << " attacked (" << r.p.r << "," << r.p.c << ") and hit something." << endl;
+            }
+        }
+        cout << "The salvo results in:" << endl;
+        target.display(attacker->isHuman());
+        
+        if (target.allShipsDestroyed())
+        {
+            cout << attacker->name() << " wins!" << endl;
+            if (defender->isHuman())
+            {
+                targets[1-me]->display(false);
+            }
+            record.winner = me+1;
+            return attacker;
+        }
+        if (shouldPause)
+        {
+            waitForEnter();
+        }
+    }
+}
+
 //******************** Game functions *******************************
 
 // These functions for the most part simply delegate to GameImpl's functions.
@@ -414,6 +716,23 @@ bool Game::addShip(int length, char symbol, string name)
              << endl;
         return false;
     }
+    return addShip(ShipShape::straight(length), symbol, name);
+}
+
+bool Game::addShip(const ShipShape& shape, char symbol, string name)
+{
+    bool fitsBoard = false;
+    for (int o = 0; o < shape.nOrientations(); o++)
+    {
+        if (shape.fits(o, Point(0, 0), rows(), cols()))
+            fitsBoard = true;
+    }
+    if (!fitsBoard)
+    {
+        cout << "Bad ship shape for " << name << "; it won't fit on the board"
+             << endl;
+        return false;
+    }
     if (!isascii(symbol)  ||  !isprint(symbol))
     {
         cout << "Unprintable character with decimal value " << symbol
@@ -437,12 +756,12 @@ bool Game::addShip(int length, char symbol, string name)
             return false;
         }
     }
-    if (totalOfLengths + length > rows() * cols())
+    if (totalOfLengths + shape.size() > rows() * cols())
     {
         cout << "Board is too small to fit all ships" << endl;
         return false;
     }
-    return m_impl->addShip(length, symbol, name);
+    return m_impl->addShip(shape, symbol, name);
 }
 
 int Game::nShips() const
@@ -456,6 +775,12 @@ int Game::shipLength(int shipId) const
     return m_impl->shipLength(shipId);
 }
 
+const ShipShape& Game::shipShape(int shipId) const
+{
+    assert(shipId >= 0  &&  shipId < nShips());
+    return m_impl->shipShape(shipId);
+}
+
 char Game::shipSymbol(int shipId) const
 {
     assert(shipId >= 0  &&  shipId < nShips());
@@ -468,6 +793,31 @@ string Game::shipName(int shipId) const
     return m_impl->shipName(shipId);
 }
 
+void Game::setSeed(unsigned seed)
+{
+    m_impl->setSeed(seed);
+}
+
+const GameRecord& Game::lastRecord() const
+{
+    return m_impl->lastRecord();
+}
+
+void Game::setTimeControl(const TimeControl& tc)
+{
+    m_impl->setTimeControl(tc);
+}
+
+void Game::setSpeculation(bool on)
+{
+    m_impl->setSpeculation(on);
+}
+
+void Game::setSalvo(int shotsPerTurn)
+{
+    m_impl->setSalvo(shotsPerTurn);
+}
+
 Player* Game::play(Player* p1, Player* p2, bool shouldPause)
 {
     if (p1 == nullptr  ||  p2 == nullptr  ||  nShips() == 0) 
@@ -7,6 +7,13 @@
 class Point;
 class Player;
 class GameImpl;
+class ShipShape;
+struct GameRecord;
+struct TimeControl;
+
+  // For Game::setSalvo: each turn fires one shot per ship the shooter still
+  // has afloat
+const int SALVO_SURVIVING_SHIPS = -1;
 
 class Game
 {
@@ -18,11 +25,23 @@ class Game
     bool isValid(Point p) const;
     Point randomPoint() const;
     bool addShip(int length, char symbol, std::string name);
+      // A ship of any shape; a ship's length is then the cells it covers
+    bool addShip(const ShipShape& shape, char symbol, std::string name);
     int nShips() const;
     int shipLength(int shipId) const;
+    const ShipShape& shipShape(int shipId) const;
     char shipSymbol(int shipId) const;
     std::string shipName(int shipId) const;
+    void setSeed(unsigned seed);
+    void setTimeControl(const TimeControl& tc);
+    void setSpeculation(bool on);
+      // Salvo mode: each turn the player fires shotsPerTurn shots together,
+      // asked for with Player::recommendAttacks and resolved with
+      // Board::attackBatch, or one per ship it has afloat if shotsPerTurn is
+      // SALVO_SURVIVING_SHIPS.  0, the default, is one shot per turn.
+    void setSalvo(int shotsPerTurn);
     Player* play(Player* p1, Player* p2, bool shouldPause = true);
+    const GameRecord& lastRecord() const;
       // We prevent a Game object from being copied or assigned
     Game(const Game&) = delete;
     Game& operator=(const Game&) = delete;
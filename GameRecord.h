@@ -0,0 +1,86 @@
+#ifndef GAMERECORD_INCLUDED
+#define GAMERECORD_INCLUDED
+
+#include "globals.h"
+#include <vector>
+
+struct PlayerParams;
+struct TimeControl;
+class OpponentModels;
+
+  // Where one ship went on a board
+struct ShipPlacement
+{
+    ShipPlacement() : orientation(HORIZONTAL) {}
+    ShipPlacement(Point p, int o) : topOrLeft(p), orientation(o) {}
+    Point topOrLeft;        // the top left corner of the ship's bounding box
+    int orientation;        // a Direction, for a straight ship
+};
+
+  // One shot as the engine resolved it
+struct ShotRecord
+{
+    int player;         // 0 for the player who moved first, 1 for the other
+    Point p;
+    bool valid;
+    bool shotHit;
+    bool shipDestroyed;
+    int shipId;         // the ship destroyed, if shipDestroyed
+};
+
+  // Everything needed to reconstruct one game: the seed its random stream
+  // started from, both fleets' layouts (indexed by shipId), and every shot.
+struct GameRecord
+{
+    GameRecord() : seed(0), winner(0) {}
+      // Record a shot as Board::attack reported it; results of invalid
+      // shots and ids of ships that weren't destroyed are dropped
+    void addShot(int player, Point p, bool validShot, bool shotHit,
+                 bool shipDestroyed, int shipId)
+    {
+        ShotRecord shot;
+        shot.player = player;
+        shot.p = p;
+        shot.valid = validShot;
+        shot.shotHit = validShot && shotHit;
+        shot.shipDestroyed = shot.shotHit && shipDestroyed;
+        shot.shipId = (shot.shipDestroyed ? shipId : 0);
+        shots.push_back(shot);
+    }
+    unsigned seed;
+    int winner;         // 1 or 2, or 0 if the game never finished
+    std::vector<ShipPlacement> layouts[2];
+    std::vector<ShotRecord> shots;
+};
+
+  // Optional changes to how a simulated game is set up
+struct GameSetup
+{
+    GameSetup()
+     : reseedAttacks(false), attackSeed(0), models(nullptr), timeControl(nullptr)
+    {
+        layouts[0] = nullptr;
+        layouts[1] = nullptr;
+        params[0] = nullptr;
+        params[1] = nullptr;
+    }
+      // If not null, the fleet of the player moving first (0) or second (1)
+      // goes exactly here instead of where that player would put it
+    const std::vector<ShipPlacement>* layouts[2];
+      // If true, the random stream restarts from attackSeed once both fleets
+      // are placed, so the shooting starts the same however they got there
+    bool reseedAttacks;
+    unsigned attackSeed;
+      // If not null, the parameters the player moving first (0) or second
+      // (1) is built with instead of the defaults
+    const PlayerParams* params[2];
+      // If not null, the opponent profiles both players learn from and add
+      // to; otherwise the game has a set of its own, which starts empty
+    OpponentModels* models;
+      // If not null, both players are on a clock under these limits, as in
+      // Game::play, and the game goes through virtual calls whatever the
+      // player types, since the loops compiled for a pair are never timed
+    const TimeControl* timeControl;
+};
+
+#endif // GAMERECORD_INCLUDED
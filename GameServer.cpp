@@ -0,0 +1,956 @@
+#include "GameServer.h"
+#include "AsyncGame.h"
+#include "Board.h"
+#include "Game.h"
+#include "GameRecord.h"
+#include "Match.h"
+#include "Player.h"
+#include "globals.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+const int MAX_EVENTS = 64;
+const size_t MAX_LINE = 4096;   // a longer line means a confused client
+
+//******************** Connection **************************************
+
+  // A nonblocking socket carrying lines of text.  Any thread may send;
+  // what the socket won't take at once waits here until epoll says the
+  // socket can take more.  Only the event loop reads.
+class Connection
+{
+  public:
+    Connection(int fd, int epollFd);
+    ~Connection();
+    int fd() const { return m_fd; }
+    void send(const string& line);
+      // Write what's waiting; false if the peer is gone
+    bool flush();
+      // Append the complete lines that have come in; false once the peer
+      // has closed or the connection is broken
+    bool receive(vector<string>& lines);
+      // Stop sending and take the socket out of the event loop
+    void close();
+
+  private:
+    bool writeSome();   // with m_mutex held
+    void watchWrites(bool on);
+    const int m_fd;
+    const int m_epoll;
+    mutex m_mutex;
+    string m_in;
+    string m_out;
+    bool m_closed;
+};
+
+Connection::Connection(int fd, int epollFd)
+ : m_fd(fd), m_epoll(epollFd), m_closed(false)
+{}
+
+Connection::~Connection()
+{
+    ::close(m_fd);
+}
+
+void Connection::watchWrites(bool on)
+{
+    epoll_event ev;
+    ev.events = EPOLLIN | (on ? uint32_t(EPOLLOUT) : 0);
+    ev.data.fd = m_fd;
+    epoll_ctl(m_epoll, EPOLL_CTL_MOD, m_fd, &ev);
+}
+
+bool Connection::writeSome()
+{
+    while (!m_out.empty())
+    {
+        ssize_t n = ::send(m_fd, m_out.data(), m_out.size(),
+                           MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n > 0)
+            m_out.erase(0, n);
+        else if (n < 0  &&  errno == EINTR)
+            continue;
+        else if (n < 0  &&  (errno == EAGAIN  ||  errno == EWOULDBLOCK))
+            return true;
+        else
+            return false;
+    }
+    return true;
+}
+
+void Connection::send(const string& line)
+{
+    lock_guard<mutex> lk(m_mutex);
+    if (m_closed)
+        return;
+    bool wasEmpty = m_out.empty();
+    m_out += line;
+    m_out += '\n';
+    if (!wasEmpty)
+        return;     // already waiting for the socket to drain
+    if (!writeSome())
+        m_out.clear();      // the loop will see the hangup
+    else if (!m_out.empty())
+        watchWrites(true);
+}
+
+bool Connection::flush()
+{
+    lock_guard<mutex> lk(m_mutex);
+    if (m_closed)
+        return true;
+    bool ok = writeSome();
+    if (ok  &&  m_out.empty())
+        watchWrites(false);
+    return ok;
+}
+
+bool Connection::receive(vector<string>& lines)
+{
+    char buf[4096];
+    bool open = true;
+    for (;;)
+    {
+        ssize_t n = ::recv(m_fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n > 0)
+        {
+            m_in.append(buf, n);
+            continue;
+        }
+        if (n < 0  &&  errno == EINTR)
+            continue;
+        if (n == 0  ||  (errno != EAGAIN  &&  errno != EWOULDBLOCK))
+            open = false;
+        break;
+    }
+    size_t start = 0;
+    for (size_t nl; (nl = m_in.find('\n', start)) != string::npos; start = nl + 1)
+    {
+        string line = m_in.substr(start, nl - start);
+        if (!line.empty()  &&  line[line.size()-1] == '\r')
+            line.erase(line.size()-1);
+        lines.push_back(line);
+    }
+    m_in.erase(0, start);
+    if (m_in.size() > MAX_LINE)
+        open = false;
+    return open;
+}
+
+void Connection::close()
+{
+    lock_guard<mutex> lk(m_mutex);
+    if (m_closed)
+        return;
+    m_closed = true;
+    m_out.clear();
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, m_fd, nullptr);
+    shutdown(m_fd, SHUT_RDWR);
+}
+
+  // Make a connected socket nonblocking and watch it for input
+static shared_ptr<Connection> watch(int fd, int epollFd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0)
+    {
+        ::close(fd);
+        return nullptr;
+    }
+    return make_shared<Connection>(fd, epollFd);
+}
+
+static bool socketAddress(string path, sockaddr_un& addr)
+{
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.empty()  ||  path.size() >= sizeof(addr.sun_path))
+        return false;
+    strcpy(addr.sun_path, path.c_str());
+    return true;
+}
+
+//******************** RemotePlayer ************************************
+
+  // A participant at the other end of a connection.  Requests go out as
+  // PLACE and ATTACK; the event loop hands the answers to answer().
+class RemotePlayer : public AsyncPlayer
+{
+  public:
+    RemotePlayer(string nm, const Game& g, shared_ptr<Connection> conn);
+    virtual string name() const { return m_name; }
+    virtual void recordOpponent(string nm);
+    virtual void requestPlacement(Board& b, function<void(bool)> done);
+    virtual void requestAttack(function<void(Point)> done);
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
+                                    bool shipDestroyed, int shipId);
+    virtual void recordAttackByOpponent(Point p);
+      // A LAYOUT or SHOT line from the client; false if nothing was asked
+    bool answer(const string& line);
+      // The client is gone: answer what's asked from now on without it
+    void disconnect();
+
+  private:
+    bool placeLayout(istringstream& in);
+    Point sweep();
+    const string m_name;
+    const Game& m_game;
+    shared_ptr<Connection> m_conn;
+    mutex m_mutex;
+    Board* m_board;
+    function<void(bool)> m_placed;
+    function<void(Point)> m_attacked;
+    bool m_gone;
+    int m_swept;
+};
+
+RemotePlayer::RemotePlayer(string nm, const Game& g, shared_ptr<Connection> conn)
+ : m_name(nm), m_game(g), m_conn(conn), m_board(nullptr), m_gone(false),
+   m_swept(0)
+{}
+
+void RemotePlayer::recordOpponent(string nm)
+{
+    m_conn->send("OPPONENT " + nm);
+}
+
+void RemotePlayer::requestPlacement(Board& b, function<void(bool)> done)
+{
+      // Once m_placed is set, the event loop may take it and answer at any
+      // moment, so what to do next is decided under the lock
+    bool asked;
+    {
+        lock_guard<mutex> lk(m_mutex);
+        asked = !m_gone;
+        if (asked)
+        {
+              // Set up before asking, since the answer can come at once
+            m_board = &b;
+            m_placed = done;
+        }
+    }
+    if (asked)
+        m_conn->send("PLACE");
+    else
+        done(false);
+}
+
+void RemotePlayer::requestAttack(function<void(Point)> done)
+{
+    bool gone;
+    {
+        lock_guard<mutex> lk(m_mutex);
+        gone = m_gone;
+        if (!gone)
+            m_attacked = done;
+    }
+    if (gone)
+        done(sweep());
+    else
+        m_conn->send("ATTACK");
+}
+
+void RemotePlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
+                                      bool shipDestroyed, int shipId)
+{
+    ostringstream msg;
+    msg << "RESULT " << p.r << " " << p.c << " " << validShot << " "
+        << shotHit << " " << shipDestroyed << " " << shipId;
+    m_conn->send(msg.str());
+}
+
+void RemotePlayer::recordAttackByOpponent(Point p)
+{
+    m_conn->send("INCOMING " + to_string(p.r) + " " + to_string(p.c));
+}
+
+  // Each cell in turn, so a game with an absent player still ends
+Point RemotePlayer::sweep()
+{
+    int k = m_swept++ % (m_game.rows() * m_game.cols());
+    return Point(k / m_game.cols(), k % m_game.cols());
+}
+
+  // Place every ship where the layout says, or none of them
+bool RemotePlayer::placeLayout(istringstream& in)
+{
+    vector<ShipPlacement> layout;
+    for (int k = 0; k < m_game.nShips(); k++)
+    {
+        ShipPlacement s;
+        char dir;
+        if (!(in >> s.topOrLeft.r >> s.topOrLeft.c >> dir)  ||
+            (dir != 'h'  &&  dir != 'v'))
+            return false;
+        s.orientation = (dir == 'h' ? HORIZONTAL : VERTICAL);
+        if (!m_board->placeShip(s.topOrLeft, k, s.orientation))
+        {
+            for (size_t j = 0; j < layout.size(); j++)
+                m_board->unplaceShip(layout[j].topOrLeft, j, layout[j].orientation);
+            return false;
+        }
+        layout.push_back(s);
+    }
+    return true;
+}
+
+bool RemotePlayer::answer(const string& line)
+{
+    istringstream in(line);
+    string word;
+    in >> word;
+    function<void(bool)> placed;
+    function<void(Point)> attacked;
+    bool ok = false;
+    Point p(-1, -1);
+    {
+        lock_guard<mutex> lk(m_mutex);
+        if (word == "LAYOUT"  &&  m_placed)
+        {
+            placed.swap(m_placed);
+              // The game is waiting on this answer, so the board is ours
+            ok = placeLayout(in);
+        }
+        else if (word == "SHOT"  &&  m_attacked)
+        {
+            attacked.swap(m_attacked);
+            if (!(in >> p.r >> p.c))
+                p = Point(-1, -1);      // a wasted shot, as off the board
+        }
+    }
+    if (placed)
+        placed(ok);
+    else if (attacked)
+        attacked(p);
+    else
+        return false;
+    return true;
+}
+
+void RemotePlayer::disconnect()
+{
+    function<void(bool)> placed;
+    function<void(Point)> attacked;
+    {
+        lock_guard<mutex> lk(m_mutex);
+        m_gone = true;
+        placed.swap(m_placed);
+        attacked.swap(m_attacked);
+    }
+    if (placed)
+        placed(false);
+    if (attacked)
+        attacked(sweep());
+}
+
+//******************** GameServerImpl **********************************
+
+class GameServerImpl
+{
+  public:
+    GameServerImpl();
+    ~GameServerImpl();
+    bool open(string socketPath, int nThreads);
+    void serve();
+    void stop();
+    long long gamesPlayed() const { return m_gamesPlayed; }
+
+  private:
+    enum ClientState { IDLE, WAITING, PLAYING };
+    struct Client
+    {
+        shared_ptr<Connection> conn;
+        ClientState state;
+        RemotePlayer* player;   // while PLAYING; owned by the session
+        unique_ptr<RemotePlayer> waiting;   // while WAITING, who it will play as
+        int session;
+    };
+    struct Session
+    {
+        unique_ptr<AsyncPlayer> players[2];
+        int clients[2];         // the clients' fds, or -1 for a computer
+        GameRecord record;
+    };
+
+    void accept();
+    void drop(int fd);
+    void handle(int fd, const string& line);
+    void play(int fd, string name, string opponent);
+    void start(int fd1, unique_ptr<AsyncPlayer> p1, int fd2,
+               unique_ptr<AsyncPlayer> p2);
+    void endSessions();
+    void wake();
+
+    Game m_game;
+    string m_path;
+    int m_listen;
+    int m_epoll;
+    int m_wake;
+    unique_ptr<GameScheduler> m_scheduler;
+    map<int, Client> m_clients;
+    int m_waiting;                      // fd of a client wanting a remote opponent
+    map<int, unique_ptr<Session>> m_sessions;
+    int m_nextSession;
+    unsigned m_nextSeed;
+    atomic<long long> m_gamesPlayed;
+    atomic<bool> m_stopping;
+    mutex m_finishedMutex;
+    vector<int> m_finished;             // sessions whose games are over
+};
+
+GameServerImpl::GameServerImpl()
+ : m_game(10, 10), m_listen(-1), m_epoll(-1), m_wake(-1), m_waiting(-1),
+   m_nextSession(0), m_nextSeed(random_device{}()), m_gamesPlayed(0),
+   m_stopping(false)
+{
+    addFleet(m_game, standardFleet());
+}
+
+GameServerImpl::~GameServerImpl()
+{
+    m_clients.clear();
+    m_sessions.clear();
+    if (m_listen >= 0)
+    {
+        ::close(m_listen);
+        unlink(m_path.c_str());
+    }
+    if (m_wake >= 0)
+        ::close(m_wake);
+    if (m_epoll >= 0)
+        ::close(m_epoll);
+}
+
+bool GameServerImpl::open(string socketPath, int nThreads)
+{
+    sockaddr_un addr;
+    if (m_listen >= 0  ||  !socketAddress(socketPath, addr))
+        return false;
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    m_wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    m_listen = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_epoll < 0  ||  m_wake < 0  ||  m_listen < 0)
+        return false;
+    unlink(socketPath.c_str());
+    if (bind(m_listen, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0  ||
+        listen(m_listen, SOMAXCONN) < 0)
+    {
+        ::close(m_listen);
+        m_listen = -1;
+        return false;
+    }
+    m_path = socketPath;
+
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = m_listen;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_listen, &ev);
+    ev.data.fd = m_wake;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wake, &ev);
+    m_scheduler.reset(new GameScheduler(nThreads));
+    return true;
+}
+
+void GameServerImpl::wake()
+{
+    uint64_t one = 1;
+    if (write(m_wake, &one, sizeof(one)) < 0)
+    {
+          // The counter is already nonzero, so the loop will wake anyway
+    }
+}
+
+void GameServerImpl::stop()
+{
+    m_stopping = true;
+    wake();
+}
+
+void GameServerImpl::accept()
+{
+    for (;;)
+    {
+        int fd = accept4(m_listen, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0)
+            return;
+        shared_ptr<Connection> conn = watch(fd, m_epoll);
+        if (conn == nullptr)
+            continue;
+        Client client;
+        client.conn = conn;
+        client.state = IDLE;
+        client.player = nullptr;
+        client.session = -1;
+        m_clients[fd] = move(client);
+    }
+}
+
+  // The client is gone; any game it's in plays on without it
+void GameServerImpl::drop(int fd)
+{
+    map<int, Client>::iterator it = m_clients.find(fd);
+    if (it == m_clients.end())
+        return;
+    Client& client = it->second;
+    if (client.state == WAITING)
+        m_waiting = -1;
+    if (client.state == PLAYING)
+    {
+        Session& s = *m_sessions[client.session];
+        s.clients[s.clients[0] == fd ? 0 : 1] = -1;
+        client.player->disconnect();
+    }
+    client.conn->close();
+    m_clients.erase(it);
+}
+
+void GameServerImpl::start(int fd1, unique_ptr<AsyncPlayer> p1, int fd2,
+                           unique_ptr<AsyncPlayer> p2)
+{
+    int id = m_nextSession++;
+    Session* s = new Session;
+    s->clients[0] = fd1;
+    s->clients[1] = fd2;
+    s->players[0] = move(p1);
+    s->players[1] = move(p2);
+    m_sessions[id].reset(s);
+
+    ostringstream fleet;
+    for (int k = 0; k < m_game.nShips(); k++)
+        fleet << " " << m_game.shipLength(k);
+    for (int i = 0; i < 2; i++)
+    {
+        if (s->clients[i] < 0)
+            continue;
+        Client& client = m_clients[s->clients[i]];
+        client.state = PLAYING;
+        client.session = id;
+        client.player = static_cast<RemotePlayer*>(s->players[i].get());
+        client.conn->send("GAME " + to_string(m_game.rows()) + " " +
+                          to_string(m_game.cols()) +
+                          (i == 0 ? " first" : " second") + fleet.str());
+    }
+
+      // The game tells the loop when it's over; the loop tidies up
+    m_scheduler->launch(m_game, *s->players[0], *s->players[1], m_nextSeed++,
+                        &s->record, [this, id]()
+    {
+        {
+            lock_guard<mutex> lk(m_finishedMutex);
+            m_finished.push_back(id);
+        }
+        wake();
+    });
+}
+
+void GameServerImpl::play(int fd, string name, string opponent)
+{
+    Client& client = m_clients[fd];
+    unique_ptr<AsyncPlayer> me(new RemotePlayer(name, m_game, client.conn));
+    if (opponent == "remote")
+    {
+        if (m_waiting < 0)
+        {
+            client.state = WAITING;
+            client.waiting.reset(static_cast<RemotePlayer*>(me.release()));
+            m_waiting = fd;
+            return;
+        }
+          // The client who waited moves first
+        int other = m_waiting;
+        m_waiting = -1;
+        unique_ptr<AsyncPlayer> first(m_clients[other].waiting.release());
+        start(other, move(first), fd, move(me));
+        return;
+    }
+    if (!isComputerType(opponent, m_game))
+    {
+        client.conn->send("ERROR unknown opponent " + opponent);
+        return;
+    }
+    unique_ptr<AsyncPlayer> bot(new SyncPlayerAdapter(
+                                createPlayer(opponent, opponent, m_game)));
+    start(fd, move(me), -1, move(bot));
+}
+
+void GameServerImpl::handle(int fd, const string& line)
+{
+    Client& client = m_clients[fd];
+    istringstream in(line);
+    string word;
+    in >> word;
+    if (word.empty())
+        return;
+    if (word == "QUIT")
+    {
+        drop(fd);
+        return;
+    }
+    if (client.state == PLAYING)
+    {
+        if (!client.player->answer(line))
+            client.conn->send("ERROR nothing was asked for " + word);
+        return;
+    }
+    string name;
+    string opponent;
+    if (word == "PLAY"  &&  client.state == IDLE  &&  (in >> name >> opponent))
+        play(fd, name, opponent);
+    else
+        client.conn->send("ERROR unexpected " + word);
+}
+
+void GameServerImpl::endSessions()
+{
+    vector<int> finished;
+    {
+        lock_guard<mutex> lk(m_finishedMutex);
+        finished.swap(m_finished);
+    }
+    for (size_t k = 0; k < finished.size(); k++)
+    {
+        map<int, unique_ptr<Session>>::iterator it = m_sessions.find(finished[k]);
+        if (it == m_sessions.end())
+            continue;
+        Session& s = *it->second;
+        for (int i = 0; i < 2; i++)
+        {
+            if (s.clients[i] < 0)
+                continue;
+            Client& client = m_clients[s.clients[i]];
+            int winner = s.record.winner;
+            client.conn->send(string("OVER ") + (winner == 0 ? "none" :
+                                                 winner == i+1 ? "win" : "lose"));
+            client.state = IDLE;
+            client.player = nullptr;
+            client.session = -1;
+        }
+        m_sessions.erase(it);
+        m_gamesPlayed++;
+    }
+}
+
+void GameServerImpl::serve()
+{
+    if (m_listen < 0)
+        return;
+    epoll_event events[MAX_EVENTS];
+    while (!m_stopping)
+    {
+        int n = epoll_wait(m_epoll, events, MAX_EVENTS, -1);
+        for (int k = 0; k < n; k++)
+        {
+            int fd = events[k].data.fd;
+            if (fd == m_listen)
+                accept();
+            else if (fd == m_wake)
+            {
+                uint64_t count;
+                if (read(m_wake, &count, sizeof(count)) < 0)
+                {
+                      // Nothing to read means nothing new to do
+                }
+                endSessions();
+            }
+            else if (m_clients.count(fd) != 0)
+            {
+                shared_ptr<Connection> conn = m_clients[fd].conn;
+                bool open = true;
+                if (events[k].events & EPOLLOUT)
+                    open = conn->flush();
+                vector<string> lines;
+                if (events[k].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                    open = conn->receive(lines) && open;
+                for (size_t i = 0; i < lines.size()  &&  m_clients.count(fd) != 0; i++)
+                    handle(fd, lines[i]);
+                if (!open)
+                    drop(fd);
+            }
+        }
+    }
+
+      // Let every game finish without its remote players, then tidy up
+    vector<int> fds;
+    for (map<int, Client>::iterator it = m_clients.begin(); it != m_clients.end(); it++)
+        fds.push_back(it->first);
+    for (size_t k = 0; k < fds.size(); k++)
+        drop(fds[k]);
+    m_scheduler->run();
+    endSessions();
+}
+
+//******************** GameServer functions ****************************
+
+// These functions simply delegate to GameServerImpl's functions.
+
+GameServer::GameServer()
+{
+    m_impl = new GameServerImpl;
+}
+
+GameServer::~GameServer()
+{
+    delete m_impl;
+}
+
+bool GameServer::open(string socketPath, int nThreads)
+{
+    return m_impl->open(socketPath, nThreads);
+}
+
+void GameServer::serve()
+{
+    m_impl->serve();
+}
+
+void GameServer::stop()
+{
+    m_impl->stop();
+}
+
+long long GameServer::gamesPlayed() const
+{
+    return m_impl->gamesPlayed();
+}
+
+//******************** load generator **********************************
+
+  // How long the load generator waits for a quiet server before giving up
+const int LOAD_TIMEOUT_MS = 10000;
+
+LoadReport::LoadReport()
+ : sessions(0), games(0), failedSessions(0), moves(0), seconds(0),
+   meanLatency(0), medianLatency(0), p99Latency(0), maxLatency(0)
+{}
+
+void LoadReport::print(ostream& out) const
+{
+    streamsize oldPrecision = out.precision(3);
+    out << sessions << " concurrent sessions played " << games << " games ("
+        << failedSessions << " sessions failed) in " << seconds << " s, "
+        << (seconds > 0 ? games / seconds : 0) << " games/s" << endl;
+    out << moves << " moves; latency per move in ms: mean " << meanLatency
+        << ", median " << medianLatency << ", 99th percentile " << p99Latency
+        << ", max " << maxLatency << endl;
+    out.precision(oldPrecision);
+}
+
+  // One simulated client: random placement and random shots
+struct LoadSession
+{
+    shared_ptr<Connection> conn;
+    mt19937 rng;
+    int rows;
+    int cols;
+    vector<int> lengths;
+    vector<bool> shotAt;
+    int gamesLeft;
+    bool waitingForTurn;
+    chrono::steady_clock::time_point shotSent;
+};
+
+static string randomLayout(LoadSession& s)
+{
+    for (;;)
+    {
+        vector<bool> used(s.rows * s.cols, false);
+        ostringstream layout;
+        layout << "LAYOUT";
+        bool ok = true;
+        for (size_t k = 0; k < s.lengths.size()  &&  ok; k++)
+        {
+            ok = false;
+            for (int tries = 0; tries < 100  &&  !ok; tries++)
+            {
+                bool across = (s.rng() & 1);
+                int r = s.rng() % s.rows;
+                int c = s.rng() % s.cols;
+                int len = s.lengths[k];
+                if ((across ? c : r) + len > (across ? s.cols : s.rows))
+                    continue;
+                ok = true;
+                for (int i = 0; i < len  &&  ok; i++)
+                    ok = !used[(across ? r : r+i) * s.cols + (across ? c+i : c)];
+                if (!ok)
+                    continue;
+                for (int i = 0; i < len; i++)
+                    used[(across ? r : r+i) * s.cols + (across ? c+i : c)] = true;
+                layout << " " << r << " " << c << (across ? " h" : " v");
+            }
+        }
+        if (ok)
+            return layout.str();
+    }
+}
+
+bool runLoadGenerator(string socketPath, int nSessions, int gamesPerSession,
+                      string opponent, LoadReport& report)
+{
+    report = LoadReport();
+    sockaddr_un addr;
+    if (!socketAddress(socketPath, addr))
+        return false;
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0)
+        return false;
+
+    map<int, LoadSession> sessions;
+    for (int k = 0; k < nSessions; k++)
+    {
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0  ||
+            connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+        {
+            if (fd >= 0)
+                close(fd);
+            report.failedSessions++;
+            continue;
+        }
+        shared_ptr<Connection> conn = watch(fd, epollFd);
+        if (conn == nullptr)
+            continue;
+        LoadSession& s = sessions[fd];
+        s.conn = conn;
+        s.rng.seed(k + 1);
+        s.gamesLeft = gamesPerSession;
+        s.waitingForTurn = false;
+    }
+    report.sessions = sessions.size();
+    if (sessions.empty())
+    {
+        close(epollFd);
+        return false;
+    }
+
+    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+    for (map<int, LoadSession>::iterator it = sessions.begin(); it != sessions.end(); it++)
+    {
+        if (it->second.gamesLeft > 0)
+            it->second.conn->send("PLAY load" + to_string(it->first) + " " + opponent);
+    }
+
+    vector<double> latencies;
+    int active = 0;
+    for (map<int, LoadSession>::iterator it = sessions.begin(); it != sessions.end(); it++)
+        active += (it->second.gamesLeft > 0);
+    epoll_event events[MAX_EVENTS];
+    while (active > 0)
+    {
+        int n = epoll_wait(epollFd, events, MAX_EVENTS, LOAD_TIMEOUT_MS);
+        if (n == 0)
+            break;      // the server has gone quiet; count the rest as failed
+        for (int k = 0; k < n; k++)
+        {
+            map<int, LoadSession>::iterator it = sessions.find(events[k].data.fd);
+            if (it == sessions.end()  ||  it->second.gamesLeft == 0)
+                continue;
+            LoadSession& s = it->second;
+            bool open = true;
+            if (events[k].events & EPOLLOUT)
+                open = s.conn->flush();
+            vector<string> lines;
+            open = s.conn->receive(lines) && open;
+            for (size_t i = 0; i < lines.size()  &&  s.gamesLeft > 0; i++)
+            {
+                istringstream in(lines[i]);
+                string word;
+                in >> word;
+                if (word == "GAME")
+                {
+                    string order;
+                    int len;
+                    in >> s.rows >> s.cols >> order;
+                    s.lengths.clear();
+                    while (in >> len)
+                        s.lengths.push_back(len);
+                    s.shotAt.assign(s.rows * s.cols, false);
+                    s.waitingForTurn = false;
+                }
+                else if (word == "PLACE")
+                    s.conn->send(randomLayout(s));
+                else if (word == "ATTACK")
+                {
+                    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+                    if (s.waitingForTurn)
+                        latencies.push_back(chrono::duration<double, milli>(
+                                                    now - s.shotSent).count());
+                    int cell;
+                    do
+                        cell = s.rng() % s.shotAt.size();
+                    while (s.shotAt[cell]);
+                    s.shotAt[cell] = true;
+                    s.shotSent = chrono::steady_clock::now();
+                    s.waitingForTurn = true;
+                    s.conn->send("SHOT " + to_string(cell / s.cols) + " " +
+                                 to_string(cell % s.cols));
+                    report.moves++;
+                }
+                else if (word == "OVER")
+                {
+                    report.games++;
+                    if (--s.gamesLeft > 0)
+                        s.conn->send("PLAY load" + to_string(it->first) + " " + opponent);
+                    else
+                        active--;
+                }
+                else if (word == "ERROR")
+                    open = false;
+            }
+            if (!open  &&  s.gamesLeft > 0)
+            {
+                s.gamesLeft = 0;
+                report.failedSessions++;
+                active--;
+            }
+        }
+    }
+    report.failedSessions += active;
+    report.seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+    for (map<int, LoadSession>::iterator it = sessions.begin(); it != sessions.end(); it++)
+    {
+        it->second.conn->send("QUIT");
+        it->second.conn->close();
+    }
+    sessions.clear();
+    close(epollFd);
+
+    if (!latencies.empty())
+    {
+        sort(latencies.begin(), latencies.end());
+        double total = 0;
+        for (size_t k = 0; k < latencies.size(); k++)
+            total += latencies[k];
+        report.meanLatency = total / latencies.size();
+        report.medianLatency = latencies[latencies.size() / 2];
+        report.p99Latency = latencies[min(latencies.size() - 1,
+                                          latencies.size() * 99 / 100)];
+        report.maxLatency = latencies.back();
+    }
+    return true;
+}
@@ -0,0 +1,76 @@
+#ifndef GAMESERVER_INCLUDED
+#define GAMESERVER_INCLUDED
+
+#include <iosfwd>
+#include <string>
+
+class GameServerImpl;
+
+  // Hosts standard games over a Unix-domain socket, all in one process: one
+  // epoll loop owns every connection, and the games run on a GameScheduler,
+  // each remote participant being an AsyncPlayer whose requests go over its
+  // socket.  The protocol is lines of text, so a person can play with a
+  // tool like socat.  From the client:
+  //   PLAY <name> <opponent>   start a game against a computer player type,
+  //                            or against the next client to ask for "remote"
+  //   LAYOUT <r> <c> <h|v> ... where each ship goes, in the order of GAME
+  //   SHOT <r> <c>             the attack asked for
+  //   QUIT
+  // From the server:
+  //   GAME <rows> <cols> <first|second> <length> ...
+  //   OPPONENT <name>
+  //   PLACE / ATTACK           requests to answer with LAYOUT / SHOT
+  //   RESULT <r> <c> <valid> <hit> <destroyed> <shipId>   of our shot
+  //   INCOMING <r> <c>         the opponent's shot
+  //   OVER <win|lose|none>
+  //   ERROR <message>
+  // A client that leaves mid-game has its remaining shots swept across the
+  // board, so its opponent's game still ends.
+class GameServer
+{
+  public:
+    GameServer();
+    ~GameServer();
+      // Listen on socketPath, replacing any stale socket there, and play
+      // games on nThreads threads.  False if the socket can't be set up.
+    bool open(std::string socketPath, int nThreads);
+      // Run the event loop until stop is called
+    void serve();
+      // Ask serve to return, from any thread.  Clients are disconnected and
+      // games in progress are played out first.
+    void stop();
+    long long gamesPlayed() const;
+      // We prevent a GameServer object from being copied or assigned
+    GameServer(const GameServer&) = delete;
+    GameServer& operator=(const GameServer&) = delete;
+
+  private:
+    GameServerImpl* m_impl;
+};
+
+  // What a load-generator run measured.  Latency is from sending a shot to
+  // being asked for the next one, so it covers the server's turnaround and
+  // the opponent's move.
+struct LoadReport
+{
+    LoadReport();
+    void print(std::ostream& out) const;
+    int sessions;
+    long long games;
+    long long failedSessions;
+    long long moves;
+    double seconds;
+    double meanLatency;     // all latencies in milliseconds
+    double medianLatency;
+    double p99Latency;
+    double maxLatency;
+};
+
+  // Open nSessions connections to a GameServer at once, and have each play
+  // gamesPerSession games against opponent with random shots.  Returns false
+  // if no connection could be made.
+bool runLoadGenerator(std::string socketPath, int nSessions,
+                      int gamesPerSession, std::string opponent,
+                      LoadReport& report);
+
+#endif // GAMESERVER_INCLUDED
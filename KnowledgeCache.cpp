@@ -0,0 +1,107 @@
+#include "KnowledgeCache.h"
+#include "Game.h"
+#include "Shape.h"
+#include "globals.h"
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+//******************** KnowledgeHash ***********************************
+
+  // splitmix64's finalizer: consecutive inputs give unrelated outputs
+static uint64_t mix(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+  // The random key of one fact
+enum Fact { MISS, HIT, SUNKCELL, SUNKSHIP, FLEET };
+
+static uint64_t key(Fact fact, uint64_t index)
+{
+    return mix((uint64_t(fact) << 56) ^ index);
+}
+
+KnowledgeHash::KnowledgeHash(const Game& g)
+{
+      // Start from a key naming the board and fleet, so the same shots
+      // against different fleets don't collide
+    uint64_t fleet = mix(uint64_t(g.rows()) << 32 | g.cols());
+    for (int k = 0; k < g.nShips(); k++)
+    {
+        const vector<Point>& cells = g.shipShape(k).cells(0);
+        for (size_t i = 0; i < cells.size(); i++)
+            fleet = mix(fleet ^ (uint64_t(k) << 16 | uint64_t(cellIndex(cells[i]))));
+    }
+    m_hash = key(FLEET, fleet);
+}
+
+void KnowledgeHash::miss(Point p)
+{
+    m_hash ^= key(MISS, cellIndex(p));
+}
+
+void KnowledgeHash::hit(Point p)
+{
+    m_hash ^= key(HIT, cellIndex(p));
+}
+
+void KnowledgeHash::sunkCell(Point p)
+{
+    m_hash ^= key(HIT, cellIndex(p)) ^ key(SUNKCELL, cellIndex(p));
+}
+
+void KnowledgeHash::sink(int shipId)
+{
+    m_hash ^= key(SUNKSHIP, shipId);
+}
+
+//******************** KnowledgeCache **********************************
+
+KnowledgeCache::KnowledgeCache(int nSlots)
+ : m_slots(nSlots > 0 ? nSlots : 1), m_locks(new mutex[NLOCKS]), m_lookups(0),
+   m_hits(0)
+{}
+
+KnowledgeCache::~KnowledgeCache()
+{}
+
+int KnowledgeCache::slotFor(uint64_t key) const
+{
+      // The low bits of a Zobrist hash are as random as the high ones
+    return key % m_slots.size();
+}
+
+bool KnowledgeCache::find(uint64_t key, vector<int>& result) const
+{
+    m_lookups.fetch_add(1, memory_order_relaxed);
+    int s = slotFor(key);
+    lock_guard<mutex> lk(m_locks[s % NLOCKS]);
+    const Slot& slot = m_slots[s];
+    if (!slot.used  ||  slot.key != key)
+        return false;
+    result = slot.result;
+    m_hits.fetch_add(1, memory_order_relaxed);
+    return true;
+}
+
+void KnowledgeCache::store(uint64_t key, const vector<int>& result)
+{
+    int s = slotFor(key);
+    lock_guard<mutex> lk(m_locks[s % NLOCKS]);
+    Slot& slot = m_slots[s];
+    slot.key = key;
+    slot.used = true;
+    slot.result = result;
+}
+
+KnowledgeCache& knowledgeCache()
+{
+    static KnowledgeCache cache(KNOWLEDGE_CACHE_SLOTS);
+    return cache;
+}
@@ -0,0 +1,77 @@
+#ifndef KNOWLEDGECACHE_INCLUDED
+#define KNOWLEDGECACHE_INCLUDED
+
+#include "globals.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class Game;
+
+  // A 64-bit Zobrist hash of what an attacker knows about the opponent's
+  // board: which cells it has missed, which it has hit on ships still
+  // afloat, which hits belong to ships it has sunk, and which ships those
+  // are.  Each fact has its own random key and the hash is their XOR, so
+  // recording a shot or a sink costs a few XORs, and the same knowledge
+  // reached in any order, in any game of the same fleet, hashes the same.
+  // The keys come from a fixed mixing function, so every thread and every
+  // run agree on them.
+class KnowledgeHash
+{
+  public:
+    KnowledgeHash(const Game& g);   // nothing known yet
+    void miss(Point p);
+    void hit(Point p);
+      // A hit cell now known to be part of a sunk ship
+    void sunkCell(Point p);
+    void sink(int shipId);
+    std::uint64_t value() const { return m_hash; }
+
+  private:
+    std::uint64_t m_hash;
+};
+
+  // A fixed number of results shared by every thread, keyed by a knowledge
+  // hash, so an expensive answer worked out for one position can be reused
+  // when the same knowledge comes up again in another game.  A result is a
+  // vector of ints whose meaning is up to whoever stores it; mix something
+  // naming the computation into the key if there's more than one kind.  A
+  // slot holds the latest result stored in it, so the cache never grows.
+  // Each group of slots has its own lock.
+class KnowledgeCache
+{
+  public:
+    KnowledgeCache(int nSlots);
+    ~KnowledgeCache();
+    bool find(std::uint64_t key, std::vector<int>& result) const;
+    void store(std::uint64_t key, const std::vector<int>& result);
+    long long lookups() const { return m_lookups; }
+    long long hits() const { return m_hits; }
+      // We prevent a KnowledgeCache object from being copied or assigned
+    KnowledgeCache(const KnowledgeCache&) = delete;
+    KnowledgeCache& operator=(const KnowledgeCache&) = delete;
+
+  private:
+    struct Slot
+    {
+        Slot() : key(0), used(false) {}
+        std::uint64_t key;
+        bool used;
+        std::vector<int> result;
+    };
+    static const int NLOCKS = 64;
+    int slotFor(std::uint64_t key) const;
+    std::vector<Slot> m_slots;
+    std::unique_ptr<std::mutex[]> m_locks;
+    mutable std::atomic<long long> m_lookups;
+    mutable std::atomic<long long> m_hits;
+};
+
+  // The cache the computer players share
+KnowledgeCache& knowledgeCache();
+
+const int KNOWLEDGE_CACHE_SLOTS = 1 << 16;
+
+#endif // KNOWLEDGECACHE_INCLUDED
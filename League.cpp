@@ -0,0 +1,255 @@
+#include "League.h"
+#include "Match.h"
+#include "Stats.h"
+#include "ThreadPool.h"
+#include "Game.h"
+#include "GameRecord.h"
+#include "OpponentModel.h"
+#include "Player.h"
+#include "globals.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+vector<LeagueVariant> standardVariants()
+{
+    vector<LeagueVariant> variants;
+    variants.push_back(LeagueVariant("standard", 10, 10, standardFleet()));
+
+    vector<ShipSpec> small;
+    small.push_back(ShipSpec(4, 'B', "battleship"));
+    small.push_back(ShipSpec(3, 'D', "destroyer"));
+    small.push_back(ShipSpec(2, 'P', "patrol boat"));
+    variants.push_back(LeagueVariant("small", 7, 7, small));
+
+    vector<ShipSpec> sparse;
+    sparse.push_back(ShipSpec(3, 'S', "submarine"));
+    sparse.push_back(ShipSpec(2, 'P', "patrol boat"));
+    sparse.push_back(ShipSpec(1, 'R', "rowboat"));
+    variants.push_back(LeagueVariant("sparse", 10, 10, sparse));
+    return variants;
+}
+
+LeagueSpec::LeagueSpec()
+ : variants(standardVariants()), gamesPerPairing(200), chunkSize(20),
+   nThreads(1), firstSeed(1)
+{
+    Game g(10, 10);
+    addFleet(g, standardFleet());
+    vector<string> all = playerTypes();
+    for (size_t k = 0; k < all.size(); k++)
+    {
+        if (isComputerType(all[k], g))
+            types.push_back(all[k]);
+    }
+}
+
+//******************** LeagueResult ************************************
+
+void LeagueResult::start(const LeagueSpec& spec)
+{
+    int n = spec.types.size();
+    m_types = spec.types;
+    m_variants.clear();
+    for (size_t v = 0; v < spec.variants.size(); v++)
+        m_variants.push_back(spec.variants[v].name);
+    m_wins.assign(spec.variants.size(),
+                  vector<vector<long long>>(n, vector<long long>(n, 0)));
+    m_unfinished = 0;
+}
+
+void LeagueResult::addGames(int v, int i, int j, long long iWins,
+                            long long jWins, long long unfinished)
+{
+    m_wins[v][i][j] += iWins;
+    m_wins[v][j][i] += jWins;
+    m_unfinished += unfinished;
+}
+
+void LeagueResult::merge(const LeagueResult& other)
+{
+    for (size_t v = 0; v < m_wins.size()  &&  v < other.m_wins.size(); v++)
+        for (size_t i = 0; i < m_wins[v].size(); i++)
+            for (size_t j = 0; j < m_wins[v][i].size(); j++)
+                m_wins[v][i][j] += other.m_wins[v][i][j];
+    m_unfinished += other.m_unfinished;
+}
+
+long long LeagueResult::wins(int i, int j) const
+{
+    long long total = 0;
+    for (size_t v = 0; v < m_wins.size(); v++)
+        total += m_wins[v][i][j];
+    return total;
+}
+
+long long LeagueResult::wins(int v, int i, int j) const
+{
+    return m_wins[v][i][j];
+}
+
+vector<double> LeagueResult::ratings() const
+{
+    int n = m_types.size();
+    vector<vector<long long>> pooled(n, vector<long long>(n, 0));
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            pooled[i][j] = wins(i, j);
+    return fitBradleyTerry(pooled);
+}
+
+vector<double> LeagueResult::ratings(int v) const
+{
+    return fitBradleyTerry(m_wins[v]);
+}
+
+void LeagueResult::print(ostream& out) const
+{
+    int n = m_types.size();
+    vector<double> pooled = ratings();
+    vector<vector<double>> byVariant;
+    for (size_t v = 0; v < m_variants.size(); v++)
+        byVariant.push_back(ratings(v));
+
+    vector<int> order;
+    for (int i = 0; i < n; i++)
+        order.push_back(i);
+    sort(order.begin(), order.end(),
+         [&](int a, int b) { return pooled[a] > pooled[b]; });
+
+    ios::fmtflags oldFlags = out.flags();
+    out << fixed << setprecision(0);
+    out << setw(4) << "Rank" << "  " << left << setw(10) << "Type" << right
+        << setw(8) << "Elo" << setw(8) << "Won";
+    for (size_t v = 0; v < m_variants.size(); v++)
+        out << setw(10) << m_variants[v];
+    out << endl;
+    for (int r = 0; r < n; r++)
+    {
+        int i = order[r];
+        long long won = 0;
+        long long played = 0;
+        for (int j = 0; j < n; j++)
+        {
+            won += wins(i, j);
+            played += wins(i, j) + wins(j, i);
+        }
+        out << setw(4) << r+1 << "  " << left << setw(10) << m_types[i] << right
+            << setw(8) << pooled[i] << setw(7)
+            << (played > 0 ? 100.0 * won / played : 0) << "%";
+        for (size_t v = 0; v < m_variants.size(); v++)
+            out << setw(10) << byVariant[v][i];
+        out << endl;
+    }
+    if (m_unfinished > 0)
+        out << m_unfinished << " games were left out because a player"
+            << " couldn't place its ships" << endl;
+    out.flags(oldFlags);
+}
+
+//******************** runLeague ***************************************
+
+void playPairing(const LeagueSpec& spec, int v, int i, int j, int first,
+                 int last, OpponentModels& models, LeagueResult& result)
+{
+    const LeagueVariant& var = spec.variants[v];
+    Game g(var.rows, var.cols);
+    addFleet(g, var.fleet);
+    string ti = spec.types[i];
+    string tj = spec.types[j];
+      // Each keeps its name whoever moves first, so the profiles kept of it
+      // gather all its games
+    string ni = ti + " (1)";
+    string nj = tj + " (2)";
+    GameSetup setup;
+    setup.models = &models;
+    long long iWins = 0;
+    long long jWins = 0;
+    long long unfinished = 0;
+    for (int k = first; k < last; k++)
+    {
+        seedRandInt(spec.firstSeed + k);
+        bool iFirst = (k % 2 == 0);
+        int winner = iFirst
+            ? simulateGame(ti, ni, tj, nj, g, nullptr, &setup)
+            : simulateGame(tj, nj, ti, ni, g, nullptr, &setup);
+        if (winner != 1  &&  winner != 2)
+            unfinished++;
+        else if ((winner == 1) == iFirst)
+            iWins++;
+        else
+            jWins++;
+    }
+    result.addGames(v, i, j, iWins, jWins, unfinished);
+}
+
+bool validLeague(const LeagueSpec& spec)
+{
+    int n = spec.types.size();
+    if (n < 2  ||  spec.gamesPerPairing < 0)
+        return false;
+    for (size_t v = 0; v < spec.variants.size(); v++)
+    {
+        const LeagueVariant& var = spec.variants[v];
+        if (var.rows < 1  ||  var.rows > MAXROWS  ||
+            var.cols < 1  ||  var.cols > MAXCOLS  ||  var.fleet.empty())
+            return false;
+        Game g(var.rows, var.cols);
+        if (!addFleet(g, var.fleet))
+            return false;
+        for (int i = 0; i < n; i++)
+        {
+            if (!isComputerType(spec.types[i], g))
+                return false;
+        }
+    }
+    return true;
+}
+
+bool runLeague(const LeagueSpec& spec, LeagueResult& result)
+{
+    if (!validLeague(spec))
+        return false;
+    result.start(spec);
+
+      // Games differ a lot in length across types and variants, so they're
+      // cut into small tasks and left to the pool to balance.  A pairing
+      // whose players learn from game to game is played whole, in order.
+    int n = spec.types.size();
+    mutex resultMutex;
+    WorkStealingPool pool(spec.nThreads);
+    for (size_t v = 0; v < spec.variants.size(); v++)
+    {
+        Game g(spec.variants[v].rows, spec.variants[v].cols);
+        addFleet(g, spec.variants[v].fleet);
+        vector<bool> learns(n);
+        for (int i = 0; i < n; i++)
+            learns[i] = learnsAcrossGames(spec.types[i], g);
+        for (int i = 0; i < n; i++)
+            for (int j = i+1; j < n; j++)
+            {
+                int chunk = (learns[i]  ||  learns[j] ? spec.gamesPerPairing
+                                                      : max(1, spec.chunkSize));
+                for (int first = 0; first < spec.gamesPerPairing; first += chunk)
+                {
+                    int last = min(first + chunk, spec.gamesPerPairing);
+                    pool.submit([&spec, &result, &resultMutex, v, i, j, first, last]()
+                    {
+                        OpponentModels models;
+                        LeagueResult part;
+                        part.start(spec);
+                        playPairing(spec, v, i, j, first, last, models, part);
+                        lock_guard<mutex> lk(resultMutex);
+                        result.merge(part);
+                    });
+                }
+            }
+    }
+    pool.wait();
+    return true;
+}
@@ -0,0 +1,88 @@
+#ifndef LEAGUE_INCLUDED
+#define LEAGUE_INCLUDED
+
+#include "Match.h"
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+class OpponentModels;
+
+  // One board size and fleet a league is played on
+struct LeagueVariant
+{
+    LeagueVariant(std::string nm, int r, int c, const std::vector<ShipSpec>& f)
+     : name(nm), rows(r), cols(c), fleet(f)
+    {}
+    std::string name;
+    int rows;
+    int cols;
+    std::vector<ShipSpec> fleet;
+};
+
+  // The standard game plus a smaller board and a sparser fleet
+std::vector<LeagueVariant> standardVariants();
+
+  // What a round-robin league plays: every pair of types meets on every
+  // variant for gamesPerPairing games, alternating who moves first.  The
+  // games are cut into tasks of chunkSize for the thread pool, except that
+  // a pairing with a type that learns across games is one task.
+struct LeagueSpec
+{
+    LeagueSpec();     // every computer player type on the standard variants
+    std::vector<std::string> types;
+    std::vector<LeagueVariant> variants;
+    int gamesPerPairing;
+    int chunkSize;
+    int nThreads;
+    unsigned firstSeed;
+};
+
+  // The pooled and per-variant results of a league
+class LeagueResult
+{
+  public:
+    LeagueResult() : m_unfinished(0) {}
+      // Empty the tables and size them for spec
+    void start(const LeagueSpec& spec);
+      // Count games between types i and j on variant v
+    void addGames(int v, int i, int j, long long iWins, long long jWins,
+                  long long unfinished);
+      // Add the counts of a result started for the same spec
+    void merge(const LeagueResult& other);
+      // Wins of type i against type j, over every variant or on variant v
+    long long wins(int i, int j) const;
+    long long wins(int v, int i, int j) const;
+    long long unfinished() const { return m_unfinished; }
+      // Bradley-Terry ratings fitted to the pooled results, or to variant v's
+    std::vector<double> ratings() const;
+    std::vector<double> ratings(int v) const;
+      // A ranking by pooled rating, with each variant's rating alongside
+    void print(std::ostream& out) const;
+
+  private:
+    std::vector<std::string> m_types;
+    std::vector<std::string> m_variants;
+    std::vector<std::vector<std::vector<long long>>> m_wins;   // [v][i][j]
+    long long m_unfinished;
+};
+
+  // Play games first through last-1 of the pairing of types i and j on
+  // variant v, in order and on this thread, adding them to result.  The
+  // players learn from and add to models, which should be the pairing's
+  // alone, holding what it learned in the pairing's earlier games.
+void playPairing(const LeagueSpec& spec, int v, int i, int j, int first,
+                 int last, OpponentModels& models, LeagueResult& result);
+
+  // Whether spec describes a league that can be played (see runLeague)
+bool validLeague(const LeagueSpec& spec);
+
+  // Play the league on spec.nThreads threads with no output.  Game k of a
+  // pairing on a variant starts its random stream from firstSeed+k, so
+  // every pairing sees the same streams.  Each pairing carries one set of
+  // opponent profiles through its games.  Returns false if the league can't
+  // be set up (fewer than two types, a type that is unknown or human, or a
+  // bad board or fleet).
+bool runLeague(const LeagueSpec& spec, LeagueResult& result);
+
+#endif // LEAGUE_INCLUDED
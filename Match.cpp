@@ -0,0 +1,235 @@
+#include "Match.h"
+#include "Stats.h"
+#include "Game.h"
+#include "Player.h"
+#include "GameRecord.h"
+#include "OpponentModel.h"
+#include "Shape.h"
+#include "globals.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+vector<ShipSpec> standardFleet()
+{
+    vector<ShipSpec> fleet;
+    fleet.push_back(ShipSpec(7, 'J', "jello"));
+    fleet.push_back(ShipSpec(5, 'A', "aircraft carrier"));
+    fleet.push_back(ShipSpec(4, 'B', "battleship"));
+    fleet.push_back(ShipSpec(3, 'D', "destroyer"));
+    fleet.push_back(ShipSpec(3, 'S', "submarine"));
+    fleet.push_back(ShipSpec(1, 'P', "patrol boat"));
+    return fleet;
+}
+
+bool addFleet(Game& g, const vector<ShipSpec>& fleet)
+{
+    for (size_t k = 0; k < fleet.size(); k++)
+    {
+        if (fleet[k].picture.empty())
+        {
+            if (!g.addShip(fleet[k].length, fleet[k].symbol, fleet[k].name))
+                return false;
+            continue;
+        }
+        ShipShape shape;
+        if (!ShipShape::fromPicture(fleet[k].picture, shape)  ||
+            !g.addShip(shape, fleet[k].symbol, fleet[k].name))
+            return false;
+    }
+    return true;
+}
+
+MatchSpec::MatchSpec()
+ : rows(10), cols(10), fleet(standardFleet()), type1("mediocre"),
+   type2("good"), nGames(1000), nThreads(1), firstSeed(1), paired(false),
+   sprt(false), elo0(0), elo1(50), alpha(0.05), beta(0.05), models(nullptr)
+{}
+
+  // Mixed into a pair's seed to start its shooting, so the attack stream
+  // doesn't just repeat the placement stream
+const unsigned ATTACK_SEED_SALT = 0x5bd1e995;
+
+bool isComputerType(string type, const Game& g)
+{
+    Player* p = createPlayer(type, "", g);
+    bool ok = (p != nullptr  &&  !p->isHuman());
+    delete p;
+    return ok;
+}
+
+bool learnsAcrossGames(string type, const Game& g)
+{
+    Player* p = createPlayer(type, "", g);
+    bool learns = (p != nullptr  &&  p->learnsAcrossGames());
+    delete p;
+    return learns;
+}
+
+  // 1 if type1 won the game, -1 if it lost, 0 if the game never finished
+static int type1Result(const GameRecord& record, bool type1First)
+{
+    if (record.winner != 1  &&  record.winner != 2)
+        return 0;
+    return (record.winner == 1) == type1First ? 1 : -1;
+}
+
+bool runMatch(const MatchSpec& spec, StatsAggregator& stats, int* verdict,
+              const GameCallback& onGame)
+{
+    if (verdict != nullptr)
+        *verdict = 0;
+    if (spec.sprt  &&  !(spec.alpha > 0  &&  spec.alpha < 1  &&
+                         spec.beta > 0  &&  spec.beta < 1  &&
+                         spec.elo0 < spec.elo1))
+        return false;
+    if (spec.rows < 1  ||  spec.rows > MAXROWS  ||
+        spec.cols < 1  ||  spec.cols > MAXCOLS  ||  spec.fleet.empty())
+        return false;
+    bool learns;
+    {
+        Game g(spec.rows, spec.cols);
+        if (!addFleet(g, spec.fleet)  ||  !isComputerType(spec.type1, g)  ||
+            !isComputerType(spec.type2, g))
+            return false;
+        learns = learnsAcrossGames(spec.type1, g)  ||
+                 learnsAcrossGames(spec.type2, g);
+    }
+    OpponentModels own;
+    OpponentModels* models = (spec.models != nullptr ? spec.models : &own);
+
+    string nm1 = spec.type1 + " (1)";
+    string nm2 = spec.type2 + " (2)";
+    atomic<int> next(0);
+    Sprt sprt(spec.elo0, spec.elo1, spec.alpha, spec.beta);
+    atomic<long long> wins(0);
+    atomic<long long> losses(0);
+    atomic<long long> pairCounts[5];
+    for (int k = 0; k < 5; k++)
+        pairCounts[k] = 0;
+    atomic<bool> settled(false);
+    atomic<int> decided(0);
+
+      // The first verdict reached is the match's: games other threads
+      // finish afterwards are counted in the statistics but can't take it
+      // back.  Once there is one, no more work is handed out.
+    auto settle = [&](int d)
+    {
+        if (d != 0)
+        {
+            int undecided = 0;
+            decided.compare_exchange_strong(undecided, d);
+            settled = true;
+        }
+    };
+
+      // Count one game for the test
+    auto score = [&](int result)
+    {
+        if (!spec.sprt  ||  result == 0)
+            return;
+        if (result > 0)
+            wins++;
+        else
+            losses++;
+        settle(sprt.decide(wins.load(), losses.load()));
+    };
+
+      // Count one pair by the half points type1 scored in it
+    auto scorePair = [&](int halfPoints)
+    {
+        if (!spec.sprt)
+            return;
+        pairCounts[halfPoints]++;
+        long long counts[5];
+        for (int k = 0; k < 5; k++)
+            counts[k] = pairCounts[k].load();
+        settle(sprt.decidePairs(counts));
+    };
+
+    auto worker = [&]()
+    {
+          // Each thread has its own Game, whose ship data the players read,
+          // and its own statistics, handed over once at the end
+        Game g(spec.rows, spec.cols);
+        addFleet(g, spec.fleet);
+        GameStats partial;
+        if (spec.paired)
+        {
+            for (int i = next++; 2*i + 1 < spec.nGames  &&  !settled; i = next++)
+            {
+                GameRecord first;
+                GameRecord second;
+                GameSetup setup;
+                setup.params[0] = &spec.params1;
+                setup.params[1] = &spec.params2;
+                setup.models = models;
+                setup.timeControl = &spec.timeControl;
+                first.seed = second.seed = spec.firstSeed + i;
+                setup.reseedAttacks = true;
+                setup.attackSeed = first.seed ^ ATTACK_SEED_SALT;
+
+                seedRandInt(first.seed);
+                simulateGame(spec.type1, nm1, spec.type2, nm2, g, &first, &setup);
+
+                  // Same boards in the same seats, so type2 now defends the
+                  // layout type1 placed and the other way round
+                if (first.layouts[0].size() == (size_t)g.nShips()  &&
+                    first.layouts[1].size() == (size_t)g.nShips())
+                {
+                    setup.layouts[0] = &first.layouts[0];
+                    setup.layouts[1] = &first.layouts[1];
+                }
+                setup.params[0] = &spec.params2;
+                setup.params[1] = &spec.params1;
+                seedRandInt(second.seed);
+                simulateGame(spec.type2, nm2, spec.type1, nm1, g, &second, &setup);
+                partial.addPair(first, second);
+                if (onGame)
+                {
+                    onGame(2*i, first, true);
+                    onGame(2*i + 1, second, false);
+                }
+                  // One sample per pair: the two games share their luck, so
+                  // scoring them apart would overstate the evidence
+                scorePair(type1Result(first, true) + type1Result(second, false) + 2);
+            }
+            stats.submit(partial);
+            return;
+        }
+        for (int k = next++; k < spec.nGames  &&  !settled; k = next++)
+        {
+            GameRecord record;
+            record.seed = spec.firstSeed + k;
+            seedRandInt(record.seed);
+            bool type1First = (k % 2 == 0);
+            GameSetup setup;
+            setup.params[0] = (type1First ? &spec.params1 : &spec.params2);
+            setup.params[1] = (type1First ? &spec.params2 : &spec.params1);
+            setup.models = models;
+            setup.timeControl = &spec.timeControl;
+            if (type1First)
+                simulateGame(spec.type1, nm1, spec.type2, nm2, g, &record, &setup);
+            else
+                simulateGame(spec.type2, nm2, spec.type1, nm1, g, &record, &setup);
+            partial.add(record, type1First);
+            if (onGame)
+                onGame(k, record, type1First);
+            score(type1Result(record, type1First));
+        }
+        stats.submit(partial);
+    };
+
+    vector<thread> threads;
+    for (int t = 1; t < spec.nThreads  &&  !learns; t++)
+        threads.push_back(thread(worker));
+    worker();
+    for (size_t t = 0; t < threads.size(); t++)
+        threads[t].join();
+    if (spec.sprt  &&  verdict != nullptr)
+        *verdict = decided;
+    return true;
+}
@@ -0,0 +1,112 @@
+#ifndef MATCH_INCLUDED
+#define MATCH_INCLUDED
+
+#include "Player.h"
+#include "TimeControl.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+class Game;
+class OpponentModels;
+class StatsAggregator;
+struct GameRecord;
+
+  // One ship of a fleet, as it would be passed to Game::addShip
+struct ShipSpec
+{
+    ShipSpec(int len, char sym, std::string nm)
+     : length(len), symbol(sym), name(nm)
+    {}
+      // A shaped ship, drawn as for ShipShape::fromPicture
+    ShipSpec(std::string pic, char sym, std::string nm)
+     : length(0), symbol(sym), name(nm), picture(pic)
+    {}
+    int length;
+    char symbol;
+    std::string name;
+    std::string picture;    // empty for a straight ship of length cells
+};
+
+  // The fleet of the standard game
+std::vector<ShipSpec> standardFleet();
+
+  // Add every ship of fleet to g; false if any of them is rejected
+bool addFleet(Game& g, const std::vector<ShipSpec>& fleet);
+
+  // Whether type is one createPlayer knows and isn't waiting on a person
+bool isComputerType(std::string type, const Game& g);
+
+  // Whether a player of type learns about its opponents from one game to
+  // the next, so that the games it plays must keep their order
+bool learnsAcrossGames(std::string type, const Game& g);
+
+  // What a head-to-head match between two computer player types plays
+struct MatchSpec
+{
+    MatchSpec();
+    int rows;
+    int cols;
+    std::vector<ShipSpec> fleet;
+    std::string type1;
+    std::string type2;
+    PlayerParams params1;
+    PlayerParams params2;
+    int nGames;
+    int nThreads;
+    unsigned firstSeed;
+    bool paired;
+      // If sprt is true, the match stops early once a sequential probability
+      // ratio test settles whether type1 is elo0 (H0) or elo1 (H1) Elo points
+      // stronger than type2, with error rates alpha and beta; nGames is then
+      // only a cap
+    bool sprt;
+    double elo0;
+    double elo1;
+    double alpha;
+    double beta;
+      // The opponent profiles the players carry from game to game; if null,
+      // the match keeps a set of its own, which starts empty
+    OpponentModels* models;
+      // Limits on how long each player may think, as in Game::play; by
+      // default there are none, and the games run through loops compiled
+      // for the pair of types, which can't be timed
+    TimeControl timeControl;
+};
+
+  // Play spec.nGames games on spec.nThreads threads with no output, feeding
+  // each thread's results into stats.  Game k starts its random stream from
+  // firstSeed+k, and type1 moves first in the even-numbered games.  If
+  // either type learns across games, the games are played one after another
+  // in seed order on this thread instead, so what the players carry from
+  // each game to the next is the same on every run.
+  //
+  // A paired match plays nGames/2 pairs, so an odd nGames leaves its last
+  // game unplayed.  It plays each seed twice instead: pair i starts from
+  // firstSeed+i with type1 moving first, then is replayed with type2 moving
+  // first, each player defending the layout the other one defended, and the
+  // shooting in both games starting from the same random stream.  The pair
+  // is scored together, which cancels most of the luck of the layouts.
+  //
+  // With spec.sprt, the test is checked after every game, or after every
+  // pair, a pair counting as type1's mean score over its two games (see
+  // Sprt), so elo0 and elo1 are per-game Elo either way.
+  // The games other threads already started are finished and counted in
+  // stats after it stops, but the verdict is the one reached when it
+  // stopped.  If verdict isn't null, it's set to 1 if H1 was accepted, -1 if
+  // H0 was, or 0 if the match ran to nGames undecided or had no test.
+  //
+  // If onGame isn't empty, it's called with each game's number, record and
+  // whether type1 moved first as soon as the game ends, from whichever
+  // thread played it; the second game of pair i is game 2i+1.
+  //
+  // Returns false if the match can't be set up (a bad board or fleet, a
+  // player type that is unknown or human, or SPRT settings that make no
+  // sense).
+typedef std::function<void(int game, const GameRecord& record,
+                           bool type1First)> GameCallback;
+bool runMatch(const MatchSpec& spec, StatsAggregator& stats,
+              int* verdict = nullptr,
+              const GameCallback& onGame = GameCallback());
+
+#endif // MATCH_INCLUDED
@@ -0,0 +1,351 @@
+#include "OpeningBook.h"
+#include "Game.h"
+#include "Shape.h"
+#include "globals.h"
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+// File layout (all fields are single bytes, so there is no byte order):
+//   "BSOB" version rows cols depth nShips length[nShips] node[2^depth - 1]
+// Each node holds the cell r*cols+c to shoot, or NOMOVE if the branch can't
+// be reached or the board has no unshot cells left.
+
+const char BOOK_MAGIC[4] = { 'B', 'S', 'O', 'B' };
+const unsigned char BOOK_VERSION = 1;
+const unsigned char NOMOVE = 0xFF;
+const int MAXDEPTH = 20;
+const int HEADERSIZE = 9; // magic, version, rows, cols, depth, nShips
+
+static vector<int> sortedLengths(const Game& g)
+{
+    vector<int> lengths;
+    for (int k = 0; k < g.nShips(); k++)
+        lengths.push_back(g.shipLength(k));
+    sort(lengths.begin(), lengths.end(), greater<int>());
+    return lengths;
+}
+
+class OpeningBookImpl
+{
+  public:
+    OpeningBookImpl();
+    ~OpeningBookImpl();
+    bool load(string filename);
+    bool matches(const Game& g) const;
+    int depth() const;
+    bool move(int node, Point& p) const;
+    int child(int node, bool shotHit) const;
+  private:
+    void unmap();
+    const unsigned char* m_base;
+    size_t m_size;
+    const unsigned char* m_nodes;
+    int m_nNodes;
+    int m_rows;
+    int m_cols;
+    int m_depth;
+};
+
+OpeningBookImpl::OpeningBookImpl()
+ : m_base(nullptr), m_size(0), m_nodes(nullptr), m_nNodes(0),
+   m_rows(0), m_cols(0), m_depth(0)
+{}
+
+OpeningBookImpl::~OpeningBookImpl()
+{
+    unmap();
+}
+
+void OpeningBookImpl::unmap()
+{
+    if (m_base != nullptr)
+        munmap(const_cast<unsigned char*>(m_base), m_size);
+    m_base = nullptr;
+    m_nodes = nullptr;
+    m_size = 0;
+    m_nNodes = 0;
+}
+
+bool OpeningBookImpl::load(string filename)
+{
+    unmap();
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0  ||  st.st_size < HEADERSIZE)
+    {
+        close(fd);
+        return false;
+    }
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // the mapping keeps the file alive
+    if (addr == MAP_FAILED)
+        return false;
+    m_base = static_cast<const unsigned char*>(addr);
+    m_size = st.st_size;
+
+      // Check the header; everything after it is used as is
+    if (!equal(BOOK_MAGIC, BOOK_MAGIC+4, m_base)  ||  m_base[4] != BOOK_VERSION)
+    {
+        unmap();
+        return false;
+    }
+    m_rows = m_base[5];
+    m_cols = m_base[6];
+    m_depth = m_base[7];
+    int nShips = m_base[8];
+    if (m_rows < 1  ||  m_rows > MAXROWS  ||  m_cols < 1  ||  m_cols > MAXCOLS  ||
+        m_depth < 1  ||  m_depth > MAXDEPTH)
+    {
+        unmap();
+        return false;
+    }
+    size_t nodeOffset = HEADERSIZE + nShips;
+    m_nNodes = (1 << m_depth) - 1;
+    if (m_size != nodeOffset + m_nNodes)
+    {
+        unmap();
+        return false;
+    }
+    m_nodes = m_base + nodeOffset;
+    return true;
+}
+
+bool OpeningBookImpl::matches(const Game& g) const
+{
+    if (m_base == nullptr  ||  g.rows() != m_rows  ||  g.cols() != m_cols  ||
+        g.nShips() != m_base[8]  ||  hasShapedShips(g))
+        return false;
+    vector<int> lengths = sortedLengths(g);
+    for (int k = 0; k < g.nShips(); k++)
+    {
+        if (lengths[k] != m_base[HEADERSIZE+k])
+            return false;
+    }
+    return true;
+}
+
+int OpeningBookImpl::depth() const
+{
+    return m_depth;
+}
+
+bool OpeningBookImpl::move(int node, Point& p) const
+{
+    if (node < 0  ||  node >= m_nNodes  ||  m_nodes[node] == NOMOVE)
+        return false;
+    p.r = m_nodes[node] / m_cols;
+    p.c = m_nodes[node] % m_cols;
+    return true;
+}
+
+int OpeningBookImpl::child(int node, bool shotHit) const
+{
+    int next = 2*node + (shotHit ? 2 : 1);
+    return next < m_nNodes ? next : -1;
+}
+
+//******************** generator ***************************************
+
+class BookGenerator
+{
+  public:
+    BookGenerator(const Game& g, int depth);
+    void fill(int node, int level);
+    vector<unsigned char> nodes;
+  private:
+    int bestShot() const;
+    int m_rows;
+    int m_cols;
+    int m_depth;
+    vector<int> m_lengths;
+    char m_know[MAXROWS][MAXCOLS]; // '.' unknown, 'o' miss, 'X' hit
+};
+
+BookGenerator::BookGenerator(const Game& g, int depth)
+ : nodes((1 << depth) - 1, NOMOVE), m_rows(g.rows()), m_cols(g.cols()),
+   m_depth(depth), m_lengths(sortedLengths(g))
+{
+    for (int r = 0; r < m_rows; r++)
+        for (int c = 0; c < m_cols; c++)
+            m_know[r][c] = '.';
+}
+
+  // Score every unshot cell by the number of ways a ship could cover it
+  // without covering a known miss.  Placements through known hits count for
+  // much more, so after a hit the book finishes off that ship.
+int BookGenerator::bestShot() const
+{
+    long long density[MAXROWS][MAXCOLS] = {};
+    for (size_t s = 0; s < m_lengths.size(); s++)
+    {
+        int length = m_lengths[s];
+        for (int d = 0; d < 2; d++)
+        {
+            int dr = (d == 0 ? 0 : 1);
+            int dc = (d == 0 ? 1 : 0);
+            for (int r = 0; r + dr*(length-1) < m_rows; r++)
+                for (int c = 0; c + dc*(length-1) < m_cols; c++)
+                {
+                    long long weight = 1;
+                    bool blocked = false;
+                    for (int k = 0; k < length  &&  !blocked; k++)
+                    {
+                        char cell = m_know[r+dr*k][c+dc*k];
+                        if (cell == 'o')
+                            blocked = true;
+                        else if (cell == 'X')
+                            weight *= 30;
+                    }
+                    if (blocked)
+                        continue;
+                    for (int k = 0; k < length; k++)
+                        density[r+dr*k][c+dc*k] += weight;
+                }
+        }
+    }
+
+    int best = -1;
+    long long bestScore = -1;
+    for (int r = 0; r < m_rows; r++)
+        for (int c = 0; c < m_cols; c++)
+        {
+            if (m_know[r][c] == '.'  &&  density[r][c] > bestScore)
+            {
+                best = r*m_cols + c;
+                bestScore = density[r][c];
+            }
+        }
+    return best;
+}
+
+void BookGenerator::fill(int node, int level)
+{
+    if (level >= m_depth)
+        return;
+    int cell = bestShot();
+    if (cell < 0)
+        return;
+    nodes[node] = static_cast<unsigned char>(cell);
+    char& know = m_know[cell/m_cols][cell%m_cols];
+    know = 'o';
+    fill(2*node + 1, level + 1);
+    know = 'X';
+    fill(2*node + 2, level + 1);
+    know = '.';
+}
+
+bool generateOpeningBook(const Game& g, int depth, string filename)
+{
+    if (depth < 1  ||  depth > MAXDEPTH  ||  g.nShips() == 0)
+        return false;
+
+    BookGenerator gen(g, depth);
+    gen.fill(0, 0);
+
+    ofstream out(filename, ios::binary | ios::trunc);
+    if (!out)
+        return false;
+    out.write(BOOK_MAGIC, 4);
+    vector<int> lengths = sortedLengths(g);
+    vector<unsigned char> header;
+    header.push_back(BOOK_VERSION);
+    header.push_back(g.rows());
+    header.push_back(g.cols());
+    header.push_back(depth);
+    header.push_back(g.nShips());
+    for (size_t k = 0; k < lengths.size(); k++)
+        header.push_back(lengths[k]);
+    out.write(reinterpret_cast<const char*>(header.data()), header.size());
+    out.write(reinterpret_cast<const char*>(gen.nodes.data()), gen.nodes.size());
+    return static_cast<bool>(out);
+}
+
+//******************** loaded books ************************************
+
+class BookShelf
+{
+  public:
+    ~BookShelf()
+    {
+        for (size_t k = 0; k < books.size(); k++)
+            delete books[k];
+    }
+    vector<OpeningBook*> books;
+};
+
+static BookShelf& shelf()
+{
+    static BookShelf s;
+    return s;
+}
+
+bool loadOpeningBook(string filename)
+{
+    OpeningBook* book = new OpeningBook;
+    if (!book->load(filename))
+    {
+        delete book;
+        return false;
+    }
+    shelf().books.push_back(book);
+    return true;
+}
+
+const OpeningBook* openingBookFor(const Game& g)
+{
+    vector<OpeningBook*>& books = shelf().books;
+    for (size_t k = 0; k < books.size(); k++)
+    {
+        if (books[k]->matches(g))
+            return books[k];
+    }
+    return nullptr;
+}
+
+//******************** OpeningBook functions ***************************
+
+OpeningBook::OpeningBook()
+{
+    m_impl = new OpeningBookImpl;
+}
+
+OpeningBook::~OpeningBook()
+{
+    delete m_impl;
+}
+
+bool OpeningBook::load(string filename)
+{
+    return m_impl->load(filename);
+}
+
+bool OpeningBook::matches(const Game& g) const
+{
+    return m_impl->matches(g);
+}
+
+int OpeningBook::depth() const
+{
+    return m_impl->depth();
+}
+
+bool OpeningBook::move(int node, Point& p) const
+{
+    return m_impl->move(node, p);
+}
+
+int OpeningBook::child(int node, bool shotHit) const
+{
+    return m_impl->child(node, shotHit);
+}
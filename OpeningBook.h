@@ -0,0 +1,43 @@
+#ifndef OPENINGBOOK_INCLUDED
+#define OPENINGBOOK_INCLUDED
+
+#include <string>
+
+class Point;
+class Game;
+class OpeningBookImpl;
+
+  // An opening book is a complete binary tree of precomputed shots for one
+  // board size and fleet.  Node 0 is the first shot; after a shot at node n,
+  // the next shot is at child(n, false) on a miss and child(n, true) on a hit.
+  // The file is memory-mapped and walked in place.
+class OpeningBook
+{
+  public:
+    OpeningBook();
+    ~OpeningBook();
+    bool load(std::string filename);
+    bool matches(const Game& g) const;
+    int depth() const;
+    bool move(int node, Point& p) const;
+    int child(int node, bool shotHit) const;
+      // We prevent an OpeningBook object from being copied or assigned
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator=(const OpeningBook&) = delete;
+
+  private:
+    OpeningBookImpl* m_impl;
+};
+
+  // Precompute the best first-depth shots for g's board and fleet and write
+  // them to filename.  Returns false if the book could not be written.
+bool generateOpeningBook(const Game& g, int depth, std::string filename);
+
+  // Map filename and make it available to AI players.  Books must be loaded
+  // before any games start; lookups afterwards are read-only.
+bool loadOpeningBook(std::string filename);
+
+  // Return a loaded book for g's board size and fleet, or nullptr if none.
+const OpeningBook* openingBookFor(const Game& g);
+
+#endif // OPENINGBOOK_INCLUDED
@@ -0,0 +1,169 @@
+#include "OpponentModel.h"
+#include "globals.h"
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+using namespace std;
+
+const int NCELLS = MAXROWS * MAXCOLS;
+const char MODEL_MAGIC[4] = { 'B', 'S', 'O', 'M' };
+
+OpponentProfile::OpponentProfile()
+ : m_games(0)
+{
+    for (int r = 0; r < MAXROWS; r++)
+        for (int c = 0; c < MAXCOLS; c++)
+        {
+            m_probes[r][c] = 0;
+            m_shipsSeen[r][c] = 0;
+            m_shotWeight[r][c] = 0;
+        }
+}
+
+void OpponentProfile::recordGame()
+{
+    m_games.fetch_add(1, memory_order_relaxed);
+}
+
+void OpponentProfile::recordProbe(Point p, bool shotHit)
+{
+    m_probes[p.r][p.c].fetch_add(1, memory_order_relaxed);
+    if (shotHit)
+        m_shipsSeen[p.r][p.c].fetch_add(1, memory_order_relaxed);
+}
+
+void OpponentProfile::recordShot(Point p, int shotNumber)
+{
+      // Earlier shots say more about how the opponent searches
+    if (shotNumber < NCELLS)
+        m_shotWeight[p.r][p.c].fetch_add(NCELLS - shotNumber, memory_order_relaxed);
+}
+
+double OpponentProfile::shipPrior(Point p) const
+{
+      // Laplace smoothing keeps unexplored cells at even odds
+    unsigned seen = m_shipsSeen[p.r][p.c].load(memory_order_relaxed);
+    unsigned probes = m_probes[p.r][p.c].load(memory_order_relaxed);
+    return (seen + 1.0) / (probes + 2.0);
+}
+
+double OpponentProfile::shotPrior(Point p) const
+{
+    unsigned games = m_games.load(memory_order_relaxed);
+    if (games == 0)
+        return 0;
+    return double(m_shotWeight[p.r][p.c].load(memory_order_relaxed)) / games;
+}
+
+unsigned OpponentProfile::games() const
+{
+    return m_games.load(memory_order_relaxed);
+}
+
+//******************** OpponentModels **********************************
+
+OpponentModels::OpponentModels()
+{}
+
+OpponentModels::~OpponentModels()
+{}
+
+OpponentProfile& OpponentModels::profile(string nm)
+{
+    lock_guard<mutex> guard(m_lock);
+    unique_ptr<OpponentProfile>& profile = m_profiles[nm];
+    if (profile == nullptr)
+        profile.reset(new OpponentProfile);
+    return *profile;
+}
+
+OpponentModels& sharedOpponentModels()
+{
+    static OpponentModels models;
+    return models;
+}
+
+// File layout: "BSOM" count, then for each profile
+//   nameLength name games probes[NCELLS] shipsSeen[NCELLS] shotWeight[NCELLS]
+// with every number an unsigned in native byte order.
+
+static void writeCounts(ostream& out, const atomic<unsigned> counts[MAXROWS][MAXCOLS])
+{
+    unsigned buf[NCELLS];
+    for (int k = 0; k < NCELLS; k++)
+        buf[k] = counts[k/MAXCOLS][k%MAXCOLS].load(memory_order_relaxed);
+    out.write(reinterpret_cast<const char*>(buf), sizeof(buf));
+}
+
+static void readCounts(istream& in, atomic<unsigned> counts[MAXROWS][MAXCOLS])
+{
+    unsigned buf[NCELLS];
+    if (!in.read(reinterpret_cast<char*>(buf), sizeof(buf)))
+        return;
+    for (int k = 0; k < NCELLS; k++)
+        counts[k/MAXCOLS][k%MAXCOLS].fetch_add(buf[k], memory_order_relaxed);
+}
+
+bool OpponentModels::save(string filename)
+{
+    ofstream out(filename, ios::binary | ios::trunc);
+    return out  &&  save(out)  &&  out.flush();
+}
+
+bool OpponentModels::load(string filename)
+{
+    ifstream in(filename, ios::binary);
+    return in  &&  load(in);
+}
+
+bool OpponentModels::save(ostream& out)
+{
+    lock_guard<mutex> guard(m_lock);
+    unsigned count = m_profiles.size();
+    out.write(MODEL_MAGIC, 4);
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    for (map<string, unique_ptr<OpponentProfile>>::iterator it = m_profiles.begin();
+                                                it != m_profiles.end(); it++)
+    {
+        unsigned nameLength = it->first.size();
+        unsigned games = it->second->games();
+        out.write(reinterpret_cast<const char*>(&nameLength), sizeof(nameLength));
+        out.write(it->first.data(), nameLength);
+        out.write(reinterpret_cast<const char*>(&games), sizeof(games));
+        writeCounts(out, it->second->m_probes);
+        writeCounts(out, it->second->m_shipsSeen);
+        writeCounts(out, it->second->m_shotWeight);
+    }
+    return static_cast<bool>(out);
+}
+
+bool OpponentModels::load(istream& in)
+{
+    char magic[4];
+    unsigned count;
+    if (!in.read(magic, 4)  ||  !equal(magic, magic+4, MODEL_MAGIC)  ||
+        !in.read(reinterpret_cast<char*>(&count), sizeof(count)))
+        return false;
+    for (unsigned k = 0; k < count; k++)
+    {
+        unsigned nameLength;
+        if (!in.read(reinterpret_cast<char*>(&nameLength), sizeof(nameLength)))
+            return false;
+        string nm(nameLength, ' ');
+        unsigned games;
+        if (!in.read(&nm[0], nameLength)  ||
+            !in.read(reinterpret_cast<char*>(&games), sizeof(games)))
+            return false;
+        OpponentProfile& profile = this->profile(nm);
+        profile.m_games.fetch_add(games, memory_order_relaxed);
+        readCounts(in, profile.m_probes);
+        readCounts(in, profile.m_shipsSeen);
+        readCounts(in, profile.m_shotWeight);
+    }
+    return static_cast<bool>(in);
+}
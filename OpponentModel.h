@@ -0,0 +1,75 @@
+#ifndef OPPONENTMODEL_INCLUDED
+#define OPPONENTMODEL_INCLUDED
+
+#include "globals.h"
+#include <atomic>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+  // Per-cell frequencies of what one named opponent has done across games:
+  // where its ships turned out to be and how early it shoots each cell.
+  // Updates are relaxed atomic increments, so players on different threads
+  // can share a profile without locking.
+class OpponentProfile
+{
+  public:
+    OpponentProfile();
+    void recordGame();
+    void recordProbe(Point p, bool shotHit);
+    void recordShot(Point p, int shotNumber);
+      // Estimated chance that p holds one of this opponent's ships
+    double shipPrior(Point p) const;
+      // How early this opponent tends to shoot p, averaged over its games;
+      // larger means sooner, 0 means never seen
+    double shotPrior(Point p) const;
+    unsigned games() const;
+      // We prevent an OpponentProfile object from being copied or assigned
+    OpponentProfile(const OpponentProfile&) = delete;
+    OpponentProfile& operator=(const OpponentProfile&) = delete;
+
+  private:
+    friend class OpponentModels;
+    std::atomic<unsigned> m_games;
+    std::atomic<unsigned> m_probes[MAXROWS][MAXCOLS];
+    std::atomic<unsigned> m_shipsSeen[MAXROWS][MAXCOLS];
+    std::atomic<unsigned> m_shotWeight[MAXROWS][MAXCOLS];
+};
+
+  // A set of profiles by opponent name.  Players that learn from each other
+  // across games only play reproducibly if the order of those games is
+  // fixed, so a match, league pairing or batch of free-for-all games keeps
+  // one set and plays its games one after another in seed order.  A game
+  // simulated alone gets a set of its own, and interactive play shares one.
+class OpponentModels
+{
+  public:
+    OpponentModels();
+    ~OpponentModels();
+      // Return the profile for the opponent named nm, creating it if
+      // needed.  Profiles live as long as the set, so callers may keep the
+      // reference.
+    OpponentProfile& profile(std::string nm);
+      // Persist every profile, to a file or as part of a stream such as a
+      // checkpoint, so a later tournament can start from them; loaded
+      // counts are added to any already in the set
+    bool save(std::string filename);
+    bool load(std::string filename);
+    bool save(std::ostream& out);
+    bool load(std::istream& in);
+      // We prevent an OpponentModels object from being copied or assigned
+    OpponentModels(const OpponentModels&) = delete;
+    OpponentModels& operator=(const OpponentModels&) = delete;
+
+  private:
+    std::mutex m_lock;
+    std::map<std::string, std::unique_ptr<OpponentProfile>> m_profiles;
+};
+
+  // The set players use when nobody lends them one: the one for
+  // interactive play, which lives until the program ends
+OpponentModels& sharedOpponentModels();
+
+#endif // OPPONENTMODEL_INCLUDED
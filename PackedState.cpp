@@ -0,0 +1,181 @@
+#include "PackedState.h"
+#include "Board.h"
+#include "Game.h"
+#include "Shape.h"
+#include "globals.h"
+#include <vector>
+
+using namespace std;
+
+const int NCELLS = MAXROWS * MAXCOLS;
+
+  // Where each ship's 10 bits start in a PackedBoard: 7 for the corner
+  // cell, 3 for the orientation (no polyomino has more than 8)
+const int SHIPBITS = NCELLS;
+const int CORNERBITS = 7;
+const int ORIENTATIONBITS = 3;
+const unsigned NOCORNER = (1u << CORNERBITS) - 1;
+
+  // Where the sunk ships' bits start in a PackedKnowledge
+const int SUNKBITS = 2 * NCELLS;
+
+static_assert(NCELLS < int(NOCORNER), "a corner cell must fit in 7 bits");
+static_assert(SHIPBITS + MAXPACKEDSHIPS * (CORNERBITS + ORIENTATIONBITS) <=
+                                                        PACKED_BYTES * 8,
+              "a PackedBoard must hold its shots and ships");
+static_assert(SUNKBITS + MAXKNOWNSHIPS <= PACKED_BYTES * 8,
+              "a PackedKnowledge must hold its cells and ships");
+
+  // Store the low n bits of v starting at bit at, least significant first
+static void putBits(unsigned char* bits, int at, int n, unsigned v)
+{
+    for (int i = 0; i < n; i++, at++)
+    {
+        if (v & (1u << i))
+            bits[at / 8] |= (1u << (at % 8));
+        else
+            bits[at / 8] &= ~(1u << (at % 8));
+    }
+}
+
+static unsigned getBits(const unsigned char* bits, int at, int n)
+{
+    unsigned v = 0;
+    for (int i = 0; i < n; i++, at++)
+    {
+        if (bits[at / 8] & (1u << (at % 8)))
+            v |= (1u << i);
+    }
+    return v;
+}
+
+//******************** PackedBoard *************************************
+
+bool packBoard(const Board& b, const Game& g, PackedBoard& packed)
+{
+    if (g.nShips() > MAXPACKEDSHIPS)
+        return false;
+    packed = PackedBoard();
+    for (int r = 0; r < g.rows(); r++)
+    {
+        for (int c = 0; c < g.cols(); c++)
+        {
+            Point p(r, c);
+            if (b.isBlocked(p))
+                return false;
+            if (b.wasAttacked(p))
+                putBits(packed.bits, cellIndex(p), 1, 1);
+        }
+    }
+    for (int k = 0; k < g.nShips(); k++)
+    {
+        int at = SHIPBITS + k * (CORNERBITS + ORIENTATIONBITS);
+        Point topLeft;
+        int orientation;
+        if (b.shipPlacement(k, topLeft, orientation))
+        {
+            putBits(packed.bits, at, CORNERBITS, cellIndex(topLeft));
+            putBits(packed.bits, at + CORNERBITS, ORIENTATIONBITS, orientation);
+        }
+        else
+            putBits(packed.bits, at, CORNERBITS, NOCORNER);
+    }
+    return true;
+}
+
+bool unpackBoard(const PackedBoard& packed, const Game& g, Board& b)
+{
+    b.clear();
+    if (g.nShips() > MAXPACKEDSHIPS)
+        return false;
+    for (int k = 0; k < g.nShips(); k++)
+    {
+        int at = SHIPBITS + k * (CORNERBITS + ORIENTATIONBITS);
+        unsigned corner = getBits(packed.bits, at, CORNERBITS);
+        if (corner == NOCORNER)
+            continue;
+        int orientation = getBits(packed.bits, at + CORNERBITS, ORIENTATIONBITS);
+        if (corner >= unsigned(NCELLS)  ||
+            orientation >= g.shipShape(k).nOrientations()  ||
+            !b.placeShip(Point(corner / MAXCOLS, corner % MAXCOLS), k, orientation))
+            return false;
+    }
+
+      // Firing the shots again in any order leaves the same board
+    for (int cell = 0; cell < NCELLS; cell++)
+    {
+        if (getBits(packed.bits, cell, 1) == 0)
+            continue;
+        bool shotHit;
+        bool shipDestroyed;
+        int shipId;
+        if (!b.attack(Point(cell / MAXCOLS, cell % MAXCOLS), shotHit,
+                      shipDestroyed, shipId))
+            return false;
+    }
+    return true;
+}
+
+//******************** PackedKnowledge *********************************
+
+CellKnowledge knowledgeAt(const PackedKnowledge& packed, Point p)
+{
+    return CellKnowledge(getBits(packed.bits, 2 * cellIndex(p), 2));
+}
+
+void setKnowledgeAt(PackedKnowledge& packed, Point p, CellKnowledge k)
+{
+    putBits(packed.bits, 2 * cellIndex(p), 2, k);
+}
+
+bool knownSunk(const PackedKnowledge& packed, int shipId)
+{
+    return getBits(packed.bits, SUNKBITS + shipId, 1) != 0;
+}
+
+void setKnownSunk(PackedKnowledge& packed, int shipId)
+{
+    putBits(packed.bits, SUNKBITS + shipId, 1, 1);
+}
+
+bool knowledgeOf(const Board& b, const Game& g, PackedKnowledge& packed)
+{
+    if (g.nShips() > MAXKNOWNSHIPS)
+        return false;
+    packed = PackedKnowledge();
+    for (int r = 0; r < g.rows(); r++)
+    {
+        for (int c = 0; c < g.cols(); c++)
+        {
+            if (b.wasAttacked(Point(r, c)))
+                setKnowledgeAt(packed, Point(r, c), MISSED_CELL);
+        }
+    }
+
+      // Every attacked cell under a ship was a hit, and a ship is sunk
+      // once all its cells are hit
+    for (int k = 0; k < g.nShips(); k++)
+    {
+        Point topLeft;
+        int orientation;
+        if (!b.shipPlacement(k, topLeft, orientation))
+            continue;
+        const vector<Point>& cells = g.shipShape(k).cells(orientation);
+        size_t nHit = 0;
+        for (size_t i = 0; i < cells.size(); i++)
+        {
+            if (b.wasAttacked(Point(topLeft.r + cells[i].r, topLeft.c + cells[i].c)))
+                nHit++;
+        }
+        CellKnowledge hit = (nHit == cells.size() ? SUNK_CELL : HIT_CELL);
+        for (size_t i = 0; i < cells.size(); i++)
+        {
+            Point p(topLeft.r + cells[i].r, topLeft.c + cells[i].c);
+            if (b.wasAttacked(p))
+                setKnowledgeAt(packed, p, hit);
+        }
+        if (hit == SUNK_CELL)
+            setKnownSunk(packed, k);
+    }
+    return true;
+}
@@ -0,0 +1,72 @@
+#ifndef PACKEDSTATE_INCLUDED
+#define PACKEDSTATE_INCLUDED
+
+#include "globals.h"
+
+class Game;
+class Board;
+
+  // Fixed-size encodings of a board and of what an attacker knows about
+  // one, for keeping a great many games in memory at once.  Each is 32
+  // bytes and holds nothing but bits, so they can be stored in arrays,
+  // copied with memcpy and compared with memcmp.  Cells are numbered
+  // r*MAXCOLS + c whatever the board's size, as in a CellMask.
+
+const int PACKED_BYTES = 32;
+
+  // The most ships a PackedBoard can hold
+const int MAXPACKEDSHIPS = 15;
+
+  // A board's ships and the shots fired at it: a bit for each cell saying
+  // whether it has been attacked, then 10 bits for each ship, the cell the
+  // corner of its bounding box is on (all ones if it hasn't been placed)
+  // and its orientation.  Which shots hit, which ships are sunk and how
+  // many follow from those, so they take no room.
+struct PackedBoard
+{
+    unsigned char bits[PACKED_BYTES];
+};
+
+  // Fill packed from b, a board of g.  Returns false if g has more than
+  // MAXPACKEDSHIPS ships or b has blocked cells, which aren't recorded.
+bool packBoard(const Board& b, const Game& g, PackedBoard& packed);
+
+  // Make b, a board of g, the board packed: clear it, place the ships and
+  // fire the shots again.  Returns false if packed isn't a board of g's
+  // fleet, leaving b as far as it got.
+bool unpackBoard(const PackedBoard& packed, const Game& g, Board& b);
+
+  // What an attacker knows about a cell
+enum CellKnowledge { UNKNOWN_CELL, MISSED_CELL, HIT_CELL, SUNK_CELL };
+
+  // The most ships whose sinking a PackedKnowledge can hold
+const int MAXKNOWNSHIPS = 56;
+
+  // What an attacker knows about a board: two bits for each cell, holding
+  // a CellKnowledge, where SUNK_CELL is a hit on a ship known to be sunk
+  // and HIT_CELL one that isn't yet, then a bit for each ship known to be
+  // sunk.  A value-initialized PackedKnowledge knows nothing.
+  //
+  // ShapeHunter, which the computer players aim with when the fleet has
+  // shaped ships, packs to and unpacks from this exactly.  Against a fleet
+  // of straight ships the mediocre and good players instead keep the cells
+  // they've chosen and a stack of follow-up cells whose contents depend on
+  // the order of earlier results, so their state can't be packed or
+  // restored; knowledgeOf gives what such a player has been told, but a
+  // player can't be resumed from it.
+struct PackedKnowledge
+{
+    unsigned char bits[PACKED_BYTES];
+};
+
+CellKnowledge knowledgeAt(const PackedKnowledge& packed, Point p);
+void setKnowledgeAt(PackedKnowledge& packed, Point p, CellKnowledge k);
+bool knownSunk(const PackedKnowledge& packed, int shipId);
+void setKnownSunk(PackedKnowledge& packed, int shipId);
+
+  // Fill packed with what the player shooting at b, a board of g, has been
+  // told by its shots: the cells hit on each ship sunk so far are
+  // SUNK_CELL.  Returns false if g has more than MAXKNOWNSHIPS ships.
+bool knowledgeOf(const Board& b, const Game& g, PackedKnowledge& packed);
+
+#endif // PACKEDSTATE_INCLUDED
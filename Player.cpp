@@ -2,30 +2,108 @@
 #include "Board.h"
 #include "Game.h"
 #include "globals.h"
+#include "OpeningBook.h"
+#include "OpponentModel.h"
+#include "StaticGame.h"
+#include "GameRecord.h"
+#include "TimeControl.h"
+#include "EnginePlayer.h"
+#include "Shape.h"
+#include "ShapeHunter.h"
 #include <iostream>
 #include <string>
 #include <stack>
+#include <vector>
+#include <random>
+#include <atomic>
+#include <thread>
+#include <algorithm>
 
 using namespace std;
 
+//*********************************************************************
+//  Player
+//*********************************************************************
+
+OpponentModels& Player::opponentModels() const
+{
+    return (m_models != nullptr ? *m_models : sharedOpponentModels());
+}
+
+double Player::timeLeft() const
+{
+    if (m_clock == nullptr)
+    {
+        return UNLIMITED_TIME;
+    }
+    return m_clock->timeLeft();
+}
+
+void Player::recordSubstitutedShot(Point /* asked */, Point /* fired */)
+{
+}
+
+void Player::recommendAttacks(int k, vector<Point>& shots)
+{
+    shots.clear();
+    for (int i=0; i<k; i++)
+    {
+        shots.push_back(recommendAttack());
+    }
+}
+
+int Player::chooseTarget(const vector<TargetInfo>& targets)
+{
+    return randInt(targets.size());
+}
+
+//a salvo from a final player type: each call names the type, so the volley costs one virtual dispatch, not k
+template <class P>
+void volleyFrom(P& p, int k, vector<Point>& shots)
+{
+    shots.clear();
+    shots.reserve(k);
+    for (int i=0; i<k; i++)
+    {
+        shots.push_back(p.P::recommendAttack());
+    }
+}
+
+//*********************************************************************
+//  PlayerParams
+//*********************************************************************
+
+//the values the players were tuned by hand with
+PlayerParams::PlayerParams()
+ : probeRadius(4), placementAttempts(50), blockFraction(0.5), huntDraws(3), placementDraws(8)
+{
+    //left, right, above, below, so a first hit is followed up below it first
+    neighborOrder[0] = 0;
+    neighborOrder[1] = 1;
+    neighborOrder[2] = 2;
+    neighborOrder[3] = 3;
+}
+
 //*********************************************************************
 //  AwfulPlayer
 //*********************************************************************
 
-class AwfulPlayer : public Player
+class AwfulPlayer final : public Player
 {
   public:
-    AwfulPlayer(string nm, const Game& g);
+    AwfulPlayer(string nm, const Game& g, const PlayerParams& params = PlayerParams());
     virtual bool placeShips(Board& b);
     virtual Point recommendAttack();
+    virtual void recommendAttacks(int k, vector<Point>& shots) { volleyFrom(*this, k, shots); }
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
                                                 bool shipDestroyed, int shipId);
     virtual void recordAttackByOpponent(Point p);
+    virtual bool attackIgnoresOpponentShots() const { return true; }
   private:
     Point m_lastCellAttacked;
 };
 
-AwfulPlayer::AwfulPlayer(string nm, const Game& g)
+AwfulPlayer::AwfulPlayer(string nm, const Game& g, const PlayerParams& /* params */)
  : Player(nm, g), m_lastCellAttacked(0, 0)
 {}
 
@@ -105,8 +183,33 @@ bool HumanPlayer::placeShips(Board& b)
         cout << name() << " must place " << game().nShips()-i << " ships." << endl; //first line to print
         b.display(false); //displays board with ships placed
         
-        Direction dir = HORIZONTAL; // to store the direction
+        int dir = HORIZONTAL; // to store the direction, or the orientation of a shaped ship
         bool continingLoop = false;
+        const ShipShape& shape = game().shipShape(i);
+        
+        while (continingLoop == false && !shape.isStraight())
+        {
+            for (int o=0; o<shape.nOrientations(); o++)
+            {
+                cout << o << ":" << endl << shape.picture(o);
+            }
+            cout << "Enter the number of the orientation of " << named << ": ";
+            int o = -1;
+            cin >> o;
+            if (!cin)
+            {
+                cin.clear();
+            }
+            cin.ignore(10000, '\n');
+            if (o >= 0 && o < shape.nOrientations())
+            {
+                dir = o;
+                continingLoop = true;
+            }
+            else{
+                cout << "Orientation must be from 0 to " << shape.nOrientations()-1 << "." << endl;
+            }
+        }
         
         while (continingLoop == false)
         {
@@ -136,7 +239,14 @@ bool HumanPlayer::placeShips(Board& b)
         {
             int r = -1;
             int c = -1;
-            cout << "Enter row and column of topmost cell (e.g., 3 5): "; //3rd line
+            if (shape.isStraight())
+            {
+                cout << "Enter row and column of topmost cell (e.g., 3 5): "; //3rd line
+            }
+            else
+            {
+                cout << "Enter row and column of the top left corner of its picture (e.g., 3 5): ";
+            }
             if (getLineWithTwoIntegers(r, c))
             {
                 Point p(r, c);
@@ -199,103 +309,242 @@ void HumanPlayer::recordAttackByOpponent(Point /* p */)
       // presumably need not do anything
 }
 
+//the computer players remember their shots as a set of cells rather than a growing list, so checking a
+//shot is one bit and a player's memory of the opponent's board is a few words whatever the game's length
+static bool wasAttacked(const CellMask& attacked, Point p)
+{
+    return p.r >= 0 && p.r < MAXROWS && p.c >= 0 && p.c < MAXCOLS && attacked.test(cellIndex(p));
+}
+
+static void rememberAttack(CellMask& attacked, Point p)
+{
+    if (p.r >= 0 && p.r < MAXROWS && p.c >= 0 && p.c < MAXCOLS)
+    {
+        attacked.set(cellIndex(p));
+    }
+}
+
+static void forgetAttack(CellMask& attacked, Point p)
+{
+    if (p.r >= 0 && p.r < MAXROWS && p.c >= 0 && p.c < MAXCOLS)
+    {
+        attacked.reset(cellIndex(p));
+    }
+}
+
+//a salvo from a final player type that remembers its shots in attacked: each pick is made as a single shot
+//would be, naming the type so the volley costs one virtual dispatch, not k, with the cells picked so far
+//in pending for the shape hunt to avoid.  A pick that repeats a cell shot before or already in the volley,
+//as a follow-up queued before its neighbor was shot can, gives way to a random cell still open
+template <class P>
+void distinctVolley(P& p, CellMask& attacked, CellMask& pending, int k, vector<Point>& shots)
+{
+    const Game& g = p.game();
+    shots.clear();
+    shots.reserve(k);
+    pending.reset();
+    for (int i=0; i<k; i++)
+    {
+        CellMask before = attacked;
+        Point a = p.P::recommendAttack();
+        if (!g.isValid(a) || wasAttacked(before, a))
+        {
+            CellMask open = boardMask(g.rows(), g.cols()) & ~before;
+            if (open.none())
+            {
+                break;
+            }
+            int pick = randInt(open.count());
+            for (int cell=0; cell<MAXROWS*MAXCOLS; cell++)
+            {
+                if (open.test(cell) && pick-- == 0)
+                {
+                    a = Point(cell / MAXCOLS, cell % MAXCOLS);
+                    break;
+                }
+            }
+            rememberAttack(attacked, a);
+        }
+        pending.set(cellIndex(a));
+        shots.push_back(a);
+    }
+    pending.reset();
+}
+
 //*********************************************************************
 //  MediocrePlayer
 //*********************************************************************
 
-class MediocrePlayer : public Player
+const unsigned SEED_STRIDE = 0x9E3779B9; //spreads consecutive attempt seeds apart
+static atomic<int> placementThreads(1);
+
+void setPlacementThreads(int n)
+{
+    placementThreads = (n < 1 ? 1 : n);
+}
+
+class MediocrePlayer final : public Player
 {
   public:
-    MediocrePlayer(string nm, const Game& g);
+    MediocrePlayer(string nm, const Game& g, const PlayerParams& params = PlayerParams());
     virtual bool isHuman() const { return false; }
-    bool place (vector<Point> vect, int shipId, Board& b); //Auxiliary function that will be recursive in placeShips
+    bool place (const vector<Point>& vect, int shipId, Board& b, vector<ShipPlacement>& layout) const; //Auxiliary function that will be recursive in placeShips
+    bool tryPlacement(unsigned seed, vector<ShipPlacement>& layout) const;
     virtual bool placeShips(Board& b);
     virtual Point recommendAttack();
+    virtual void recommendAttacks(int k, vector<Point>& shots) { distinctVolley(*this, alreadyAttacked, m_volley, k, shots); }
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
     virtual void recordAttackByOpponent(Point p);
+    virtual void recordSubstitutedShot(Point asked, Point fired);
+    virtual bool attackIgnoresOpponentShots() const { return true; }
 private:
+    PlayerParams m_params;
     bool recs = false;
     Point justAttacked;
     stack <Point> pointToCheck;
-    vector <Point> alreadyAttacked;
+    CellMask alreadyAttacked; //a bit per cell, however long the game goes
+    CellMask m_volley; //cells already chosen for the volley being picked, so the shape hunt spreads it out
+    bool m_shaped; //the fleet has ships that aren't straight
+    ShapeHunter m_shapes;
 };
 
-MediocrePlayer::MediocrePlayer(string nm, const Game& g)
- : Player(nm, g){}
+MediocrePlayer::MediocrePlayer(string nm, const Game& g, const PlayerParams& params)
+ : Player(nm, g), m_params(params), m_shaped(hasShapedShips(g)), m_shapes(g)
+{
+    m_params.placementAttempts = max(1, m_params.placementAttempts);
+}
 
-//recursive auxiliary function to place ships
-bool MediocrePlayer::place (vector<Point> vect, int shipId, Board& b)
+//recursive auxiliary function to place ships; layout records where each ship went
+bool MediocrePlayer::place (const vector<Point>& vect, int shipId, Board& b, vector<ShipPlacement>& layout) const
 {
     if (shipId >= game().nShips()) //base case when we ran out of ships to place
     {
         return true;
     }
     
+    int nOrientations = game().shipShape(shipId).nOrientations();
     for (int i=0; i<vect.size(); i++) //look thru every point on the board until a placement is successful
     {
-        Direction dir = HORIZONTAL;
-        Direction dir2 = VERTICAL;
-        if (b.placeShip(vect[i], shipId, dir)) //try placing the ship horizontally
+        for (int o=0; o<nOrientations; o++) //try every way the ship can lie; for a straight ship, horizontally and then vertically
         {
-            if (place(vect, shipId+1, b)) //if that was successful, try the next ship
+            if (b.placeShip(vect[i], shipId, o))
             {
-                return true;
-            }
-            else{
-                b.unplaceShip(vect[i], shipId, dir); //if that was unsuccessful, unplace the ship
+                layout.push_back(ShipPlacement(vect[i], o));
+                if (place(vect, shipId+1, b, layout)) //if that was successful, try the next ship
+                {
+                    return true;
+                }
+                else{
+                    layout.pop_back();
+                    b.unplaceShip(vect[i], shipId, o); //if that was unsuccessful, unplace the ship
+                }
             }
         }
-        if (b.placeShip(vect[i], shipId, dir2)) //try placing the ship vertically
+    }
+    
+    return false; //if the ships could not be placed, return false
+}
+
+//one placement attempt on a private scratch board, driven only by its own seed, so attempts can run on any thread in any order
+bool MediocrePlayer::tryPlacement(unsigned seed, vector<ShipPlacement>& layout) const
+{
+    mt19937 saved = randomEngine(); //leave this thread's own stream as we found it
+    seedRandInt(seed);
+    
+    Board scratch(game());
+    scratch.block(m_params.blockFraction); // first block out the points
+    
+    //create a vector of points on the board
+    vector <Point> allPoints;
+    
+    for (int i=0; i<game().rows(); i++)
+    {
+        for (int j=0; j<game().cols(); j++)
         {
-            if (place(vect, shipId+1, b)) //if that was successful, try the next ship
-            {
-                return true;
-            }
-            else{
-                b.unplaceShip(vect[i], shipId, dir2); //if that was unsuccessful, unplace the ship
-            }
+            allPoints.push_back(Point(i, j));
         }
     }
     
-    return false; //if the ships could not be placed, return false
+    layout.clear();
+    bool havePlaced = place(allPoints, 0, scratch, layout); //this will place all the ships
+    
+    randomEngine() = saved;
+    return havePlaced;
 }
 
 bool MediocrePlayer::placeShips(Board& b)
 {
-    for (int i=0; i<50; i++)
+    //every attempt's seed comes from one draw on our stream, so the layout is the same however many threads look for it
+    unsigned base = randomEngine()();
+    int winner = -1;
+    vector<ShipPlacement> layout;
+    
+    int attempts = m_params.placementAttempts;
+    int nThreads = min(placementThreads.load(), attempts);
+    if (nThreads <= 1)
     {
-        b.block(); // first block out the points
-        
-        //create a vector of points on the board
-        vector <Point> allPoints;
-        
-        for (int i=0; i<game().rows(); i++)
+        for (int i=0; i<attempts && winner<0; i++)
         {
-            for (int j=0; j<game().cols(); j++)
+            if (tryPlacement(base + i*SEED_STRIDE, layout))
             {
-                Point p;
-                p.r = i;
-                p.c = j;
-                allPoints.push_back(p);
+                winner = i;
             }
         }
-        
-        //Auxiliary function that will be recursive
-        int shipId = 0;
-        bool havePlaced = place(allPoints, shipId, b); //this will place all the ships
-        
-        b.unblock(); //now unblock
-        
-        if (havePlaced) // if successful, end here
+    }
+    else
+    {
+        //attempts are handed out in order; a thread stops once a lower-numbered attempt has succeeded,
+        //so the winner is always the attempt the sequential loop would have found
+        vector< vector<ShipPlacement> > layouts(attempts);
+        atomic<int> next(0);
+        atomic<int> best(attempts);
+        auto worker = [&]()
         {
-            return true;
+            for (int i = next++; i < attempts && i < best; i = next++)
+            {
+                if (tryPlacement(base + i*SEED_STRIDE, layouts[i]))
+                {
+                    int bestSoFar = best.load();
+                    while (i < bestSoFar && !best.compare_exchange_weak(bestSoFar, i))
+                        ;
+                }
+            }
+        };
+        vector<thread> threads;
+        for (int t=1; t<nThreads; t++)
+        {
+            threads.push_back(thread(worker));
+        }
+        worker();
+        for (size_t t=0; t<threads.size(); t++)
+        {
+            threads[t].join();
+        }
+        if (best < attempts)
+        {
+            winner = best;
+            layout = layouts[winner];
         }
-        
-        //if not, go through another iteration of the for loop until it does 50 tries
-//        allPoints.erase(allPoints.begin(), allPoints.end());
     }
-
-    return false; //after 50 tries and no way to place all of the ships, return false
+    
+    if (winner < 0)
+    {
+        return false; //after every try and no way to place all of the ships, return false
+    }
+    
+    //commit the winning layout to the real board
+    for (int k=0; k<(int)layout.size(); k++)
+    {
+        if (!b.placeShip(layout[k].topOrLeft, k, layout[k].orientation))
+        {
+            for (int j=0; j<k; j++)
+            {
+                b.unplaceShip(layout[j].topOrLeft, j, layout[j].orientation);
+            }
+            return false;
+        }
+    }
+    return true;
 }
 
 void MediocrePlayer::recordAttackByOpponent(Point /* p */)
@@ -303,10 +552,24 @@ void MediocrePlayer::recordAttackByOpponent(Point /* p */)
       // presumably need not do anything
 }
 
+void MediocrePlayer::recordSubstitutedShot(Point asked, Point fired)
+{
+    //a cell marked but never shot could hold the last segment afloat, and the hunt would never end
+    forgetAttack(alreadyAttacked, asked);
+    rememberAttack(alreadyAttacked, fired);
+}
+
 Point MediocrePlayer::recommendAttack()
 {
     Point a;
     
+    //with shaped ships, a hit is followed up where the ship could still lie; hunting stays random
+    if (m_shaped && m_shapes.chasing() && m_shapes.bestCell(a, m_volley))
+    {
+        rememberAttack(alreadyAttacked, a);
+        return a;
+    }
+    
     if (!recs) //State 1
     {
         bool continuing = true;
@@ -315,14 +578,7 @@ Point MediocrePlayer::recommendAttack()
         {
             a = game().randomPoint();
             
-            bool notFound = true;
-            for (int i=0; i<alreadyAttacked.size(); i++)
-            {
-                if(alreadyAttacked[i].r == a.r && alreadyAttacked[i].c == a.c)
-                {
-                    notFound = false;
-                }
-            }
+            bool notFound = !wasAttacked(alreadyAttacked, a);
             if (notFound)
             {
                 continuing = false;
@@ -340,14 +596,7 @@ Point MediocrePlayer::recommendAttack()
                 a = pointToCheck.top();
                 pointToCheck.pop();
                 
-                bool notFound = true;
-                for (int i=0; i<alreadyAttacked.size(); i++)
-                {
-                    if(alreadyAttacked[i].r == a.r && alreadyAttacked[i].c == a.c)
-                    {
-                        notFound = false;
-                    }
-                }
+                bool notFound = !wasAttacked(alreadyAttacked, a);
                 if (notFound)
                 {
                     continuing = false;
@@ -362,14 +611,7 @@ Point MediocrePlayer::recommendAttack()
                 recs = false; //reset
                 a = game().randomPoint();
                 
-                bool notFound = true;
-                for (int i=0; i<alreadyAttacked.size(); i++)
-                {
-                    if(alreadyAttacked[i].r == a.r && alreadyAttacked[i].c == a.c)
-                    {
-                        notFound = false;
-                    }
-                }
+                bool notFound = !wasAttacked(alreadyAttacked, a);
                 if (notFound)
                 {
                     continuing = false;
@@ -378,16 +620,25 @@ Point MediocrePlayer::recommendAttack()
         }
     }
 
-    alreadyAttacked.push_back(a);
+    rememberAttack(alreadyAttacked, a);
     return a;
 }
 
 void MediocrePlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
 {
+    if (m_shaped)
+    {
+        if (validShot)
+        {
+            m_shapes.record(p, shotHit, shipDestroyed, shipId);
+        }
+        return;
+    }
+    
     if (!recs && shotHit && !shipDestroyed)
     {
         justAttacked = p;
-        for (int i=1; i<=4; i++)
+        for (int i=1; i<=m_params.probeRadius; i++)
         {
             Point q;
             Point k;
@@ -400,7 +651,7 @@ void MediocrePlayer::recordAttackResult(Point p, bool validShot, bool shotHit, b
             pointToCheck.push(q);
             pointToCheck.push(k);
         }
-        for (int i=1; i<=4; i++)
+        for (int i=1; i<=m_params.probeRadius; i++)
         {
             Point q;
             Point k;
@@ -429,54 +680,199 @@ void MediocrePlayer::recordAttackResult(Point p, bool validShot, bool shotHit, b
 //  GoodPlayer
 //*********************************************************************
 
-class GoodPlayer : public Player
+class GoodPlayer final : public Player
 {
   public:
-    GoodPlayer(string nm, const Game& g);
+    GoodPlayer(string nm, const Game& g, const PlayerParams& params = PlayerParams());
     virtual bool isHuman() const { return false; }
     virtual bool placeShips(Board& b);
     virtual Point recommendAttack();
+    virtual void recommendAttacks(int k, vector<Point>& shots) { distinctVolley(*this, alreadyAttacked, m_volley, k, shots); }
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
     virtual void recordAttackByOpponent(Point p);
+    virtual void recordSubstitutedShot(Point asked, Point fired);
+    virtual void recordOpponent(string nm);
+    virtual bool attackIgnoresOpponentShots() const { return true; } //the opponent's shots only shape our placement
+    virtual bool learnsAcrossGames() const { return true; }
 private:
+    Point huntPoint() const;
+    bool fits(Board& b, Point p, int shipId, int orientation) const;
+    double exposure(Point p, int shipId, int orientation) const;
+    PlayerParams m_params;
     int recs = 1;
     stack <Point> pointStack;
     Point justAttacked;
-    vector <Point> alreadyAttacked;
+    CellMask alreadyAttacked; //a bit per cell, however long the game goes
+    CellMask m_volley; //cells already chosen for the volley being picked, so the shape hunt spreads it out
+    const OpeningBook* m_book;
+    int m_bookNode; //current node in the opening book, or -1 once we've left it
+    OpponentProfile* m_opponent = nullptr; //what we've learned about this opponent in earlier games
+    int m_opponentShots = 0;
+    bool m_shaped; //the fleet has ships that aren't straight
+    ShapeHunter m_shapes;
 };
 
-GoodPlayer::GoodPlayer(string nm, const Game& g)
- : Player(nm, g){}
+const int MAX_PLACEMENT_TRIES = 1000;
+
+GoodPlayer::GoodPlayer(string nm, const Game& g, const PlayerParams& params)
+ : Player(nm, g), m_params(params), m_book(openingBookFor(g)), m_shaped(hasShapedShips(g)), m_shapes(g)
+{
+    m_bookNode = (m_book != nullptr ? 0 : -1);
+}
+
+void GoodPlayer::recordOpponent(string nm)
+{
+    m_opponent = &opponentModels().profile(nm);
+    m_opponent->recordGame();
+}
+
+//returns true if the ship could go there, leaving the board unchanged
+bool GoodPlayer::fits(Board& b, Point p, int shipId, int orientation) const
+{
+    if (!b.placeShip(p, shipId, orientation))
+    {
+        return false;
+    }
+    b.unplaceShip(p, shipId, orientation);
+    return true;
+}
+
+//how early the opponent has tended to shoot the cells a ship would cover
+double GoodPlayer::exposure(Point p, int shipId, int orientation) const
+{
+    double total = 0;
+    const vector<Point>& cells = game().shipShape(shipId).cells(orientation);
+    for (int k=0; k<(int)cells.size(); k++)
+    {
+        total += m_opponent->shotPrior(Point(p.r+cells[k].r, p.c+cells[k].c));
+    }
+    return total;
+}
 
 bool GoodPlayer::placeShips(Board& b)
 {
-    //place ships randomly
+    //with no history, one random spot is as good as any other
+    int draws = 1;
+    if (m_opponent != nullptr && m_opponent->games() > 1)
+    {
+        draws = max(1, m_params.placementDraws);
+    }
+    
+    //place ships randomly, keeping the least exposed of the random spots that fit
     for (int i=0; i<game().nShips(); i++)
     {
-        Point p = game().randomPoint();
+        Point best;
+        int bestDir = HORIZONTAL;
+        double bestExposure = 0;
+        int found = 0;
+        int nOrientations = game().shipShape(i).nOrientations(); //2 for a straight ship: HORIZONTAL and VERTICAL
+        for (int t=0; t<MAX_PLACEMENT_TRIES && found<draws; t++)
+        {
+            Point p = game().randomPoint();
+            int dir = randInt(nOrientations);
+            if (!fits(b, p, i, dir))
+            {
+                continue;
+            }
+            double e = (draws > 1 ? exposure(p, i, dir) : 0);
+            if (found == 0 || e < bestExposure)
+            {
+                best = p;
+                bestDir = dir;
+                bestExposure = e;
+            }
+            found++;
+        }
         
-        int num = randInt(2);
-        if (num==0)
+        //crowded board: fall back to the first spot that fits at all
+        for (int r=0; r<game().rows() && found==0; r++)
         {
-            b.placeShip(p, i, HORIZONTAL);
+            for (int c=0; c<game().cols() && found==0; c++)
+            {
+                for (int o=0; o<nOrientations && found==0; o++)
+                {
+                    if (fits(b, Point(r, c), i, o))
+                    {
+                        best = Point(r, c);
+                        bestDir = o;
+                        found++;
+                    }
+                }
+            }
         }
-        else{
-            b.placeShip(p, i, VERTICAL);
+        
+        if (found == 0 || !b.placeShip(best, i, bestDir))
+        {
+            return false;
         }
     }
     
     return true;
 }
 
-void GoodPlayer::recordAttackByOpponent(Point /* p */)
+void GoodPlayer::recordAttackByOpponent(Point p)
 {
-      // presumably need not do anything
+    if (m_opponent != nullptr)
+    {
+        m_opponent->recordShot(p, m_opponentShots++);
+    }
+}
+
+void GoodPlayer::recordSubstitutedShot(Point asked, Point fired)
+{
+    //a cell marked but never shot could hold the last segment afloat, and the hunt would never end
+    forgetAttack(alreadyAttacked, asked);
+    rememberAttack(alreadyAttacked, fired);
+    m_bookNode = -1; //the book's line assumed the shot we chose
+}
+
+//a random point to hunt at; once the opponent has a history, the likeliest of a few random draws
+Point GoodPlayer::huntPoint() const
+{
+    Point a = game().randomPoint();
+    if (m_opponent == nullptr || m_opponent->games() <= 1)
+    {
+        return a;
+    }
+    for (int i=1; i<m_params.huntDraws; i++)
+    {
+        //a cell already shot never wins, or late in a game the likeliest cells would all be shot and the hunt could draw forever
+        Point q = game().randomPoint();
+        if (wasAttacked(alreadyAttacked, q))
+        {
+            continue;
+        }
+        if (wasAttacked(alreadyAttacked, a) || m_opponent->shipPrior(q) > m_opponent->shipPrior(a))
+        {
+            a = q;
+        }
+    }
+    return a;
 }
 
 Point GoodPlayer::recommendAttack()
 {
     Point a;
     
+    //while the game is still in the opening book, its move costs nothing
+    if (m_bookNode >= 0 && m_book->move(m_bookNode, a))
+    {
+        bool notFound = !wasAttacked(alreadyAttacked, a);
+        if (notFound)
+        {
+            rememberAttack(alreadyAttacked, a);
+            return a;
+        }
+    }
+    m_bookNode = -1;
+    
+    //with shaped ships, every shot goes where the most ways the ships afloat could lie agree
+    if (m_shaped && m_shapes.bestCell(a, m_volley))
+    {
+        rememberAttack(alreadyAttacked, a);
+        return a;
+    }
+    
     switch (recs)
     {
         case 1:
@@ -485,15 +881,8 @@ Point GoodPlayer::recommendAttack()
             
             while (continuing)
             {
-                a = game().randomPoint();
-                bool notFound = true;
-                for (int i=0; i<alreadyAttacked.size(); i++)
-                {
-                    if(alreadyAttacked[i].r == a.r && alreadyAttacked[i].c == a.c)
-                    {
-                        notFound = false;
-                    }
-                }
+                a = huntPoint();
+                bool notFound = !wasAttacked(alreadyAttacked, a);
                 if (notFound)
                 {
                     continuing = false;
@@ -516,16 +905,9 @@ Point GoodPlayer::recommendAttack()
                 else
                 {
                     recs = 1; //reset
-                    a = game().randomPoint();
-                }
-                bool notFound = true;
-                for (int i=0; i<alreadyAttacked.size(); i++)
-                {
-                    if(alreadyAttacked[i].r == a.r && alreadyAttacked[i].c == a.c)
-                    {
-                        notFound = false;
-                    }
+                    a = huntPoint();
                 }
+                bool notFound = !wasAttacked(alreadyAttacked, a);
                 if (notFound)
                 {
                     continuing = false;
@@ -549,15 +931,8 @@ Point GoodPlayer::recommendAttack()
                 
                 while (continuing)
                 {
-                    a = game().randomPoint();
-                    bool notFound = true;
-                    for (int i=0; i<alreadyAttacked.size(); i++)
-                    {
-                        if(alreadyAttacked[i].r == a.r && alreadyAttacked[i].c == a.c)
-                        {
-                            notFound = false;
-                        }
-                    }
+                    a = huntPoint();
+                    bool notFound = !wasAttacked(alreadyAttacked, a);
                     if (notFound)
                     {
                         continuing = false;
@@ -571,35 +946,51 @@ Point GoodPlayer::recommendAttack()
         }
     }
     
-    alreadyAttacked.push_back(a);
+    rememberAttack(alreadyAttacked, a);
     return a;
 }
 
 void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
 {
-    if (recs==1 && shotHit && !shipDestroyed)
+    if (m_opponent != nullptr && validShot)
     {
-        justAttacked = p;
-        //add all 4 directions from the attacked point
-        Point n (p.r,p.c-1);
-        if (game().isValid(n)) //1 left
+        m_opponent->recordProbe(p, shotHit);
+    }
+    
+    //the book only branches on hit or miss, so a sink takes us out of it
+    if (m_bookNode >= 0)
+    {
+        if (validShot && !shipDestroyed)
         {
-            pointStack.push(n);
+            m_bookNode = m_book->child(m_bookNode, shotHit);
         }
-        Point s (p.r,p.c+1);
-        if (game().isValid(s)) //1 right
+        else
         {
-            pointStack.push(s);
+            m_bookNode = -1;
         }
-        Point g (p.r-1,p.c);
-        if (game().isValid(g)) //1 above
+    }
+    
+    if (m_shaped)
+    {
+        if (validShot)
         {
-            pointStack.push(g);
+            m_shapes.record(p, shotHit, shipDestroyed, shipId);
         }
-        Point b (p.r+1,p.c);
-        if (game().isValid(b)) //1 below
+        return;
+    }
+    
+    if (recs==1 && shotHit && !shipDestroyed)
+    {
+        justAttacked = p;
+        //add all 4 directions from the attacked point: left, right, above, below, queued in the order the params say
+        Point neighbors[4] = { Point(p.r,p.c-1), Point(p.r,p.c+1), Point(p.r-1,p.c), Point(p.r+1,p.c) };
+        for (int k=0; k<4; k++)
         {
-            pointStack.push(b);
+            int d = m_params.neighborOrder[k];
+            if (d >= 0 && d < 4 && game().isValid(neighbors[d]))
+            {
+                pointStack.push(neighbors[d]);
+            }
         }
         
         recs = 2; // this makes recommendAttack go into State 2 next time it's called
@@ -680,22 +1071,272 @@ void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool
 //  createPlayer
 //*********************************************************************
 
-Player* createPlayer(string type, string nm, const Game& g)
+static const string types[] = {
+    "human", "awful", "mediocre", "good"
+};
+
+static int playerTypeIndex(string type)
 {
-    static string types[] = {
-        "human", "awful", "mediocre", "good"
-    };
-    
     int pos;
     for (pos = 0; pos != sizeof(types)/sizeof(types[0])  &&
                                                      type != types[pos]; pos++)
         ;
-    switch (pos)
+    return pos;
+}
+
+vector<string> playerTypes()
+{
+    return vector<string>(types, types + sizeof(types)/sizeof(types[0]));
+}
+
+Player* createPlayer(string type, string nm, const Game& g, const PlayerParams& params)
+{
+    if (type.compare(0, string(ENGINE_PREFIX).size(), ENGINE_PREFIX) == 0)
+    {
+        return createEnginePlayer(type.substr(string(ENGINE_PREFIX).size()), nm, g);
+    }
+    switch (playerTypeIndex(type))
     {
       case 0:  return new HumanPlayer(nm, g);
-      case 1:  return new AwfulPlayer(nm, g);
-      case 2:  return new MediocrePlayer(nm, g);
-      case 3:  return new GoodPlayer(nm, g);
+      case 1:  return new AwfulPlayer(nm, g, params);
+      case 2:  return new MediocrePlayer(nm, g, params);
+      case 3:  return new GoodPlayer(nm, g, params);
       default: return nullptr;
     }
 }
+
+//*********************************************************************
+//  simulateGames
+//*********************************************************************
+
+//one quiet game between two concrete player types, recorded if record isn't null
+template <class A, class B>
+int playPair(string nm1, string nm2, const Game& g, GameRecord* record, const GameSetup* setup)
+{
+    static const PlayerParams defaults;
+    OpponentModels own; //games on other threads mustn't change how this one goes
+    OpponentModels* models = (setup != nullptr && setup->models != nullptr ? setup->models : &own);
+    bool plain = (setup == nullptr || (setup->layouts[0] == nullptr && setup->layouts[1] == nullptr &&
+                                       !setup->reseedAttacks && setup->params[0] == nullptr && setup->params[1] == nullptr));
+    if (record == nullptr && plain)
+    {
+        A a(nm1, g, defaults);
+        B b(nm2, g, defaults);
+        a.setOpponentModels(models);
+        b.setOpponentModels(models);
+        return playStatic(g, a, b);
+    }
+    A a(nm1, g, (setup != nullptr && setup->params[0] != nullptr) ? *setup->params[0] : defaults);
+    B b(nm2, g, (setup != nullptr && setup->params[1] != nullptr) ? *setup->params[1] : defaults);
+    a.setOpponentModels(models);
+    b.setOpponentModels(models);
+    GameRecord scratch;
+    GameSetup none;
+    SetupObserver obs(g, (record != nullptr ? *record : scratch), (setup != nullptr ? *setup : none));
+    obs.record.winner = playStatic(g, a, b, obs);
+    return obs.record.winner;
+}
+
+typedef int PlayFn(string nm1, string nm2, const Game& g, GameRecord* record, const GameSetup* setup);
+
+//the game loop for a pair of computer player types, or nullptr if either isn't one
+static PlayFn* playFn(string type1, string type2)
+{
+    //indexed like createPlayer's types less one
+    static PlayFn* const pairs[3][3] = {
+        { playPair<AwfulPlayer, AwfulPlayer>, playPair<AwfulPlayer, MediocrePlayer>, playPair<AwfulPlayer, GoodPlayer> },
+        { playPair<MediocrePlayer, AwfulPlayer>, playPair<MediocrePlayer, MediocrePlayer>, playPair<MediocrePlayer, GoodPlayer> },
+        { playPair<GoodPlayer, AwfulPlayer>, playPair<GoodPlayer, MediocrePlayer>, playPair<GoodPlayer, GoodPlayer> },
+    };
+    
+    int i = playerTypeIndex(type1) - 1;
+    int j = playerTypeIndex(type2) - 1;
+    if (i < 0 || i >= 3 || j < 0 || j >= 3)
+    {
+        return nullptr;
+    }
+    return pairs[i][j];
+}
+
+//a player on a clock for the whole game, timing its placement and each shot as Game::play does; a late shot
+//goes to a random cell it hasn't shot at, or, under the other penalty, the player forfeits
+class TimedPlayer final : public Player
+{
+  public:
+    TimedPlayer(Player& p, const TimeControl& tc)
+     : Player(p.name(), p.game()), m_player(p), m_limits(tc), m_clock(tc), m_forfeited(false)
+    {
+        m_player.setClock(&m_clock);
+    }
+    ~TimedPlayer() { m_player.setClock(nullptr); }
+    bool forfeited() const { return m_forfeited; }
+    virtual void recordOpponent(string nm) { m_player.recordOpponent(nm); }
+    virtual bool placeShips(Board& b);
+    virtual Point recommendAttack();
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
+    virtual void recordAttackByOpponent(Point p) { m_player.recordAttackByOpponent(p); }
+private:
+    Player& m_player;
+    TimeControl m_limits;
+    MoveClock m_clock;
+    CellMask m_shotAt; //the cells shot so far, so a random shot is never wasted
+    bool m_forfeited;
+};
+
+bool TimedPlayer::placeShips(Board& b)
+{
+    //a fleet can't be placed at random after the fact, so a late placement is only punished by forfeiting
+    m_clock.startMove();
+    bool placed = m_player.placeShips(b);
+    if (m_clock.stopMove() && m_limits.penalty == FORFEIT)
+    {
+        m_forfeited = true;
+    }
+    return placed;
+}
+
+Point TimedPlayer::recommendAttack()
+{
+    m_clock.startMove();
+    Point p = m_player.recommendAttack();
+    if (!m_clock.stopMove())
+    {
+        return p;
+    }
+    if (m_limits.penalty == FORFEIT)
+    {
+        m_forfeited = true;
+        return p;
+    }
+    CellMask open = boardMask(game().rows(), game().cols()) & ~m_shotAt;
+    if (open.none())
+    {
+        return p;
+    }
+    Point asked = p;
+    int pick = randInt(open.count());
+    for (int cell=0; cell<MAXROWS*MAXCOLS; cell++)
+    {
+        if (open.test(cell) && pick-- == 0)
+        {
+            p = Point(cell / MAXCOLS, cell % MAXCOLS);
+            break;
+        }
+    }
+    m_player.recordSubstitutedShot(asked, p);
+    return p;
+}
+
+void TimedPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
+{
+    rememberAttack(m_shotAt, p);
+    m_player.recordAttackResult(p, validShot, shotHit, shipDestroyed, shipId);
+}
+
+//stops the game as soon as a timed player forfeits, leaving the shot it was late with out of the record
+struct TimedObserver : public SetupObserver
+{
+    TimedObserver(const Game& g, GameRecord& r, const GameSetup& s, const TimedPlayer& a, const TimedPlayer& b)
+     : SetupObserver(g, r, s), first(a), second(b)
+    {}
+    bool placed(const Board& b1, const Board& b2)
+    {
+        return SetupObserver::placed(b1, b2) && !first.forfeited() && !second.forfeited();
+    }
+    bool shot(const ShotRecord& s)
+    {
+        return !first.forfeited() && !second.forfeited() && SetupObserver::shot(s);
+    }
+    const TimedPlayer& first;
+    const TimedPlayer& second;
+};
+
+//the same game through virtual calls, for computer types with no compiled loop such as external engines,
+//and for games on a clock
+static int playCreated(string type1, string nm1, string type2, string nm2, const Game& g, GameRecord* record, const GameSetup* setup)
+{
+    static const PlayerParams defaults;
+    Player* a = createPlayer(type1, nm1, g, (setup != nullptr && setup->params[0] != nullptr) ? *setup->params[0] : defaults);
+    Player* b = createPlayer(type2, nm2, g, (setup != nullptr && setup->params[1] != nullptr) ? *setup->params[1] : defaults);
+    int winner = -1;
+    if (a != nullptr && b != nullptr && !a->isHuman() && !b->isHuman())
+    {
+        OpponentModels own;
+        OpponentModels* models = (setup != nullptr && setup->models != nullptr ? setup->models : &own);
+        a->setOpponentModels(models);
+        b->setOpponentModels(models);
+        GameRecord scratch;
+        GameSetup none;
+        GameRecord& r = (record != nullptr ? *record : scratch);
+        if (setup != nullptr && setup->timeControl != nullptr && setup->timeControl->enabled())
+        {
+            TimedPlayer ta(*a, *setup->timeControl);
+            TimedPlayer tb(*b, *setup->timeControl);
+            TimedObserver obs(g, r, *setup, ta, tb);
+            winner = playStatic(g, ta, tb, obs);
+            if (ta.forfeited() || tb.forfeited())
+            {
+                winner = (ta.forfeited() ? 2 : 1);
+            }
+            r.winner = winner;
+        }
+        else
+        {
+            SetupObserver obs(g, r, (setup != nullptr ? *setup : none));
+            winner = r.winner = playStatic(g, *a, *b, obs);
+        }
+    }
+    delete a;
+    delete b;
+    return winner;
+}
+
+int simulateGame(string type1, string nm1, string type2, string nm2, const Game& g, GameRecord* record, const GameSetup* setup)
+{
+    if (g.nShips() == 0)
+    {
+        return -1;
+    }
+    //the compiled loops are never timed, so a game on a clock goes through virtual calls whatever the types
+    PlayFn* play = playFn(type1, type2);
+    if (play == nullptr || (setup != nullptr && setup->timeControl != nullptr && setup->timeControl->enabled()))
+    {
+        return playCreated(type1, nm1, type2, nm2, g, record, setup);
+    }
+    return play(nm1, nm2, g, record, setup);
+}
+
+int simulateGames(string type1, string nm1, string type2, string nm2, const Game& g, int nGames)
+{
+    PlayFn* play = playFn(type1, type2);
+    PlayFn* swapped = playFn(type2, type1);
+    if (g.nShips() == 0)
+    {
+        return -1;
+    }
+    
+    //the first mover alternates, and what the players learn carries from game to game
+    OpponentModels models;
+    GameSetup setup;
+    setup.models = &models;
+    int nWins = 0;
+    for (int k=0; k<nGames; k++)
+    {
+        int winner;
+        if (k%2 == 0)
+        {
+            winner = (play != nullptr ? play(nm1, nm2, g, nullptr, &setup) : playCreated(type1, nm1, type2, nm2, g, nullptr, &setup));
+            nWins += (winner == 1);
+        }
+        else
+        {
+            winner = (swapped != nullptr ? swapped(nm2, nm1, g, nullptr, &setup) : playCreated(type2, nm2, type1, nm1, g, nullptr, &setup));
+            nWins += (winner == 2);
+        }
+        if (winner < 0)
+        {
+            return -1;
+        }
+    }
+    return nWins;
+}
@@ -2,16 +2,49 @@
 #define PLAYER_INCLUDED
 
 #include <string>
+#include <vector>
 
 class Point;
 class Board;
 class Game;
+struct GameRecord;
+struct GameSetup;
+class MoveClock;
+class OpponentModels;
+
+  // The tuning constants of the computer players.  A default-constructed
+  // PlayerParams holds the hand-tuned values they always used.
+struct PlayerParams
+{
+    PlayerParams();
+      // MediocrePlayer: how far along each line from a first hit to probe,
+      // how many blocked-board placements to try, and what fraction of the
+      // board each attempt blocks
+    int probeRadius;
+    int placementAttempts;
+    double blockFraction;
+      // GoodPlayer: the order the four neighbors of a first hit are queued
+      // in (0 left, 1 right, 2 above, 3 below; the last queued is shot
+      // first), and how many random candidates it compares when hunting and
+      // when placing each ship once it knows the opponent
+    int neighborOrder[4];
+    int huntDraws;
+    int placementDraws;
+};
+
+  // An opponent still in a free-for-all game
+struct TargetInfo
+{
+    int seat;
+    int shipsLeft;
+    int shotsTaken;     // how many shots its board has taken so far
+};
 
 class Player
 {
   public:
     Player(std::string nm, const Game& g)
-     : m_name(nm), m_game(g)
+     : m_name(nm), m_game(g), m_clock(nullptr), m_models(nullptr)
     {}
 
     virtual ~Player() {}
@@ -21,11 +54,55 @@ class Player
 
     virtual bool isHuman() const { return false; }
 
+      // Called once per game, before placeShips, with the opponent's name
+    virtual void recordOpponent(std::string /* nm */) {}
+
+      // Under a time control, the engine lends the player its clock for the
+      // game.  A player that searches can check these to stop early.
+    void setClock(const MoveClock* clock) { m_clock = clock; }
+
+      // A player that learns about its opponents across games keeps what it
+      // learns in these profiles.  Whoever runs a match or league lends the
+      // players of a pairing one set for all its games, playing them in
+      // seed order if learnsAcrossGames is true for either player, so the
+      // pairing plays the same whatever else is running; a player lent none
+      // uses sharedOpponentModels().
+    void setOpponentModels(OpponentModels* models) { m_models = models; }
+    OpponentModels& opponentModels() const;
+    virtual bool learnsAcrossGames() const { return false; }
+
+      // True if recommendAttack's answer never depends on the shots passed
+      // to recordAttackByOpponent, and recommendAttack doesn't touch
+      // anything recordAttackByOpponent does except through atomics.  Then
+      // the engine may work out the next attack on another thread while the
+      // opponent is still choosing, since one answer serves whatever the
+      // opponent's shot turns out to be.
+    virtual bool attackIgnoresOpponentShots() const { return false; }
+      // Seconds left for the current move; very large with no time control
+    double timeLeft() const;
+    bool outOfTime() const { return timeLeft() <= 0; }
+
     virtual bool placeShips(Board& b) = 0;
     virtual Point recommendAttack() = 0;
+      // Fill shots with k attacks to fire together as one salvo, none
+      // repeating a cell already shot at or another shot of the salvo; the
+      // engine counts any that do as wasted.  Their results come back
+      // afterwards through recordAttackResult, in the same order.  The
+      // default asks recommendAttack k times, which only keeps to that for
+      // a player whose choices don't wait on results, such as a sweep.
+    virtual void recommendAttacks(int k, std::vector<Point>& shots);
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
                                         bool shipDestroyed, int shipId) = 0;
     virtual void recordAttackByOpponent(Point p) = 0;
+      // When a late move is penalized with a random shot, the engine fires
+      // at fired instead of the cell asked that the player recommended, and
+      // then reports fired's result through recordAttackResult.  asked
+      // hasn't been shot, so a player remembering its shots should forget it.
+      // The default does nothing.
+    virtual void recordSubstitutedShot(Point asked, Point fired);
+      // In a free-for-all, which of targets (never empty) to shoot at this
+      // turn, as an index into it.  The default picks one at random.
+    virtual int chooseTarget(const std::vector<TargetInfo>& targets);
       // We prevent any kind of Player object from being copied or assigned
     Player(const Player&) = delete;
     Player& operator=(const Player&) = delete;
@@ -33,8 +110,40 @@ class Player
   private:
     std::string m_name;
     const Game& m_game;
+    const MoveClock* m_clock;
+    OpponentModels* m_models;
 };
 
-Player* createPlayer(std::string type, std::string nm, const Game& g);
+Player* createPlayer(std::string type, std::string nm, const Game& g,
+                     const PlayerParams& params = PlayerParams());
+
+  // Every type createPlayer knows, human included
+std::vector<std::string> playerTypes();
+
+  // Play one game between two computer player types with no output, through
+  // a game loop compiled for that pair of types, continuing this thread's
+  // random stream.  If record isn't null it gets the layouts, shots and
+  // winner; its seed is left to the caller.  A setup can preset layouts,
+  // restart the stream after placement, give either player parameters
+  // other than the defaults, lend both the opponent profiles they carry
+  // from earlier games, or put both on a clock, under which a player that
+  // forfeits loses.  Returns 1 or 2 for the winner, 0
+  // if a player couldn't place its ships, or -1 if either type is unknown or
+  // human.
+int simulateGame(std::string type1, std::string nm1,
+                 std::string type2, std::string nm2, const Game& g,
+                 GameRecord* record = nullptr, const GameSetup* setup = nullptr);
+
+  // Play nGames games between two computer player types with no output,
+  // alternating who moves first, through a game loop compiled for that pair
+  // of types.  The players carry one set of opponent profiles from game to
+  // game.  Returns how many games type1 won, or -1 if either type is
+  // unknown or human.
+int simulateGames(std::string type1, std::string nm1,
+                  std::string type2, std::string nm2, const Game& g, int nGames);
+
+  // Let mediocre players try up to n placement attempts at once.  The layout
+  // chosen for a given random stream is the same for every n.
+void setPlacementThreads(int n);
 
 #endif // PLAYER_INCLUDED
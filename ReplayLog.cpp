@@ -0,0 +1,416 @@
+#include "ReplayLog.h"
+#include "Game.h"
+#include "GameRecord.h"
+#include "Shape.h"
+#include "globals.h"
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+// File layout: "BSRL" version, then one entry per game:
+//   size(4)  seed(4) rows cols nShips winner
+//   two player types, each a length byte and that many characters
+//   nShips x (length symbol)
+//   2 x nShips placements: cell | 0x80 if vertical, or NOCELL if unplaced
+//   shots, 2 bytes each: cell | 0x80 if the second player fired it,
+//                        valid | hit<<1 | destroyed<<2 | shipId<<3
+// Multi-byte numbers are little-endian.  size counts the bytes after itself,
+// so a reader can step from game to game without decoding them.  Version 1
+// logs had no player types; their entries can't be told apart from these,
+// so they're refused rather than misread.
+
+const char LOG_MAGIC[4] = { 'B', 'S', 'R', 'L' };
+const unsigned char LOG_VERSION = 2;
+const int LOG_HEADERSIZE = 5;
+const int GAME_HEADERSIZE = 8;
+const unsigned char NOCELL = 0x7F;
+const int MAXLOGGEDSHIPS = 32;      // shipId has 5 bits in a shot
+const size_t MAXTYPELENGTH = 255;
+const size_t WRITEBUFSIZE = 1 << 16;
+
+static void putU32(vector<unsigned char>& buf, unsigned v)
+{
+    for (int k = 0; k < 4; k++)
+        buf.push_back((v >> (8*k)) & 0xFF);
+}
+
+static unsigned getU32(const unsigned char* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (unsigned(p[3]) << 24);
+}
+
+//******************** ReplayWriter ************************************
+
+class ReplayWriterImpl
+{
+  public:
+    ~ReplayWriterImpl();
+    bool open(string filename);
+    bool append(const Game& g, const GameRecord& record, string type1, string type2);
+    bool flush();
+  private:
+    ofstream m_out;
+    vector<unsigned char> m_buf;
+};
+
+ReplayWriterImpl::~ReplayWriterImpl()
+{
+    flush();
+}
+
+bool ReplayWriterImpl::open(string filename)
+{
+    flush();
+    if (m_out.is_open())
+        m_out.close();
+
+      // A new log gets the file header; an existing one is appended to, if
+      // it's in this version's format
+    ifstream existing(filename, ios::binary | ios::ate);
+    bool isNew = !existing  ||  existing.tellg() == 0;
+    if (!isNew)
+    {
+        char header[LOG_HEADERSIZE];
+        existing.seekg(0);
+        if (!existing.read(header, LOG_HEADERSIZE)  ||
+            !equal(LOG_MAGIC, LOG_MAGIC+4, header)  ||
+            static_cast<unsigned char>(header[4]) != LOG_VERSION)
+            return false;
+    }
+    existing.close();
+
+    m_out.open(filename, ios::binary | ios::app);
+    if (!m_out)
+        return false;
+    m_buf.reserve(WRITEBUFSIZE);
+    if (isNew)
+    {
+        m_buf.insert(m_buf.end(), LOG_MAGIC, LOG_MAGIC+4);
+        m_buf.push_back(LOG_VERSION);
+    }
+    return true;
+}
+
+bool ReplayWriterImpl::append(const Game& g, const GameRecord& record, string type1, string type2)
+{
+    int n = g.nShips();
+    if (!m_out.is_open()  ||  n > MAXLOGGEDSHIPS  ||  hasShapedShips(g)  ||
+        type1.size() > MAXTYPELENGTH  ||  type2.size() > MAXTYPELENGTH)
+        return false;
+
+    size_t start = m_buf.size();
+    putU32(m_buf, 0);  // size, filled in below
+    putU32(m_buf, record.seed);
+    m_buf.push_back(g.rows());
+    m_buf.push_back(g.cols());
+    m_buf.push_back(n);
+    m_buf.push_back(record.winner);
+    m_buf.push_back(type1.size());
+    m_buf.insert(m_buf.end(), type1.begin(), type1.end());
+    m_buf.push_back(type2.size());
+    m_buf.insert(m_buf.end(), type2.begin(), type2.end());
+    for (int k = 0; k < n; k++)
+    {
+        m_buf.push_back(g.shipLength(k));
+        m_buf.push_back(g.shipSymbol(k));
+    }
+    for (int b = 0; b < 2; b++)
+        for (int k = 0; k < n; k++)
+        {
+            if (k >= (int)record.layouts[b].size())
+            {
+                m_buf.push_back(NOCELL);
+                continue;
+            }
+            const ShipPlacement& s = record.layouts[b][k];
+            unsigned char cell = s.topOrLeft.r * g.cols() + s.topOrLeft.c;
+            m_buf.push_back(cell | (s.orientation == VERTICAL ? 0x80 : 0));
+        }
+    for (size_t i = 0; i < record.shots.size(); i++)
+    {
+        const ShotRecord& shot = record.shots[i];
+        unsigned char cell = (g.isValid(shot.p) ? shot.p.r * g.cols() + shot.p.c : NOCELL);
+        m_buf.push_back(cell | (shot.player == 1 ? 0x80 : 0));
+        m_buf.push_back((shot.valid ? 1 : 0) | (shot.shotHit ? 2 : 0) |
+                        (shot.shipDestroyed ? 4 : 0) | (shot.shipId << 3));
+    }
+    unsigned size = m_buf.size() - start - 4;
+    for (int k = 0; k < 4; k++)
+        m_buf[start+k] = (size >> (8*k)) & 0xFF;
+
+    if (m_buf.size() >= WRITEBUFSIZE)
+        return flush();
+    return true;
+}
+
+bool ReplayWriterImpl::flush()
+{
+    if (!m_out.is_open())
+        return false;
+    if (!m_buf.empty())
+    {
+        m_out.write(reinterpret_cast<const char*>(m_buf.data()), m_buf.size());
+        m_buf.clear();
+    }
+    m_out.flush();
+    return static_cast<bool>(m_out);
+}
+
+//******************** ReplayGame **************************************
+
+unsigned ReplayGame::seed() const
+{
+    return getU32(m_data);
+}
+
+int ReplayGame::rows() const
+{
+    return m_data[4];
+}
+
+int ReplayGame::cols() const
+{
+    return m_data[5];
+}
+
+int ReplayGame::nShips() const
+{
+    return m_data[6];
+}
+
+int ReplayGame::winner() const
+{
+    return m_data[7];
+}
+
+string ReplayGame::playerType(int player) const
+{
+    const unsigned char* t = m_data + GAME_HEADERSIZE;
+    if (player == 1)
+        t += 1 + t[0];
+    else if (player != 0)
+        return "";
+    return string(reinterpret_cast<const char*>(t+1), t[0]);
+}
+
+size_t ReplayGame::shipsOffset() const
+{
+    const unsigned char* t = m_data + GAME_HEADERSIZE;
+    size_t len1 = t[0];
+    return GAME_HEADERSIZE + 2 + len1 + t[1+len1];
+}
+
+int ReplayGame::shipLength(int shipId) const
+{
+    return m_data[shipsOffset() + 2*shipId];
+}
+
+char ReplayGame::shipSymbol(int shipId) const
+{
+    return m_data[shipsOffset() + 2*shipId + 1];
+}
+
+bool ReplayGame::shipPlacement(int board, int shipId, Point& topOrLeft, Direction& dir) const
+{
+    if (board < 0  ||  board > 1  ||  shipId < 0  ||  shipId >= nShips())
+        return false;
+    unsigned char b = m_data[shipsOffset() + 2*nShips() + board*nShips() + shipId];
+    if (b == NOCELL)
+        return false;
+    topOrLeft = Point((b & 0x7F) / cols(), (b & 0x7F) % cols());
+    dir = (b & 0x80 ? VERTICAL : HORIZONTAL);
+    return true;
+}
+
+int ReplayGame::nShots() const
+{
+    return (m_size - shipsOffset() - 4*nShips()) / 2;
+}
+
+ShotRecord ReplayGame::shot(int i) const
+{
+    const unsigned char* s = m_data + shipsOffset() + 4*nShips() + 2*i;
+    ShotRecord shot;
+    shot.player = (s[0] & 0x80 ? 1 : 0);
+    int cell = s[0] & 0x7F;
+    shot.p = (cell == NOCELL ? Point(-1, -1) : Point(cell / cols(), cell % cols()));
+    shot.valid = (s[1] & 1) != 0;
+    shot.shotHit = (s[1] & 2) != 0;
+    shot.shipDestroyed = (s[1] & 4) != 0;
+    shot.shipId = s[1] >> 3;
+    return shot;
+}
+
+GameRecord ReplayGame::toRecord() const
+{
+    GameRecord record;
+    record.seed = seed();
+    record.winner = winner();
+    for (int b = 0; b < 2; b++)
+        for (int k = 0; k < nShips(); k++)
+        {
+            ShipPlacement s;
+            Direction dir;
+            if (!shipPlacement(b, k, s.topOrLeft, dir))
+                break;
+            s.orientation = dir;
+            record.layouts[b].push_back(s);
+        }
+    for (int i = 0; i < nShots(); i++)
+        record.shots.push_back(shot(i));
+    return record;
+}
+
+//******************** ReplayReader ************************************
+
+class ReplayReaderImpl
+{
+  public:
+    ReplayReaderImpl();
+    ~ReplayReaderImpl();
+    bool open(string filename);
+    bool next(ReplayGame& game);
+    void rewind();
+  private:
+    void unmap();
+    const unsigned char* m_base;
+    size_t m_size;
+    size_t m_pos;
+};
+
+ReplayReaderImpl::ReplayReaderImpl()
+ : m_base(nullptr), m_size(0), m_pos(0)
+{}
+
+ReplayReaderImpl::~ReplayReaderImpl()
+{
+    unmap();
+}
+
+void ReplayReaderImpl::unmap()
+{
+    if (m_base != nullptr)
+        munmap(const_cast<unsigned char*>(m_base), m_size);
+    m_base = nullptr;
+    m_size = 0;
+    m_pos = 0;
+}
+
+bool ReplayReaderImpl::open(string filename)
+{
+    unmap();
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0  ||  st.st_size < LOG_HEADERSIZE)
+    {
+        close(fd);
+        return false;
+    }
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+        return false;
+    m_base = static_cast<const unsigned char*>(addr);
+    m_size = st.st_size;
+      // Games are read front to back once
+    madvise(addr, m_size, MADV_SEQUENTIAL);
+
+    if (!equal(LOG_MAGIC, LOG_MAGIC+4, m_base)  ||  m_base[4] != LOG_VERSION)
+    {
+        unmap();
+        return false;
+    }
+    m_pos = LOG_HEADERSIZE;
+    return true;
+}
+
+bool ReplayReaderImpl::next(ReplayGame& game)
+{
+    if (m_base == nullptr  ||  m_pos + 4 > m_size)
+        return false;
+    size_t size = getU32(m_base + m_pos);
+      // A truncated last game (say, from a killed run) ends the log
+    if (size < GAME_HEADERSIZE + 2u  ||  m_pos + 4 + size > m_size)
+        return false;
+    game.m_data = m_base + m_pos + 4;
+    game.m_size = size;
+    const unsigned char* t = game.m_data + GAME_HEADERSIZE;
+    if (size < GAME_HEADERSIZE + 2u + t[0]  ||
+        size < game.shipsOffset() + 4u*game.nShips())
+        return false;
+    m_pos += 4 + size;
+    return true;
+}
+
+void ReplayReaderImpl::rewind()
+{
+    if (m_base != nullptr)
+        m_pos = LOG_HEADERSIZE;
+}
+
+//******************** ReplayWriter and ReplayReader functions *********
+
+ReplayWriter::ReplayWriter()
+{
+    m_impl = new ReplayWriterImpl;
+}
+
+ReplayWriter::~ReplayWriter()
+{
+    delete m_impl;
+}
+
+bool ReplayWriter::open(string filename)
+{
+    return m_impl->open(filename);
+}
+
+bool ReplayWriter::append(const Game& g, string type1, string type2)
+{
+    return m_impl->append(g, g.lastRecord(), type1, type2);
+}
+
+bool ReplayWriter::append(const Game& g, const GameRecord& record, string type1, string type2)
+{
+    return m_impl->append(g, record, type1, type2);
+}
+
+bool ReplayWriter::flush()
+{
+    return m_impl->flush();
+}
+
+ReplayReader::ReplayReader()
+{
+    m_impl = new ReplayReaderImpl;
+}
+
+ReplayReader::~ReplayReader()
+{
+    delete m_impl;
+}
+
+bool ReplayReader::open(string filename)
+{
+    return m_impl->open(filename);
+}
+
+bool ReplayReader::next(ReplayGame& game)
+{
+    return m_impl->next(game);
+}
+
+void ReplayReader::rewind()
+{
+    m_impl->rewind();
+}
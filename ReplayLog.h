@@ -0,0 +1,86 @@
+#ifndef REPLAYLOG_INCLUDED
+#define REPLAYLOG_INCLUDED
+
+#include "GameRecord.h"
+#include <string>
+#include <cstddef>
+
+class Game;
+class ReplayWriterImpl;
+class ReplayReaderImpl;
+
+  // Appends games to a binary replay log.  Each game costs a few bytes of
+  // header, two bytes per ship per board and two bytes per shot; writes are
+  // buffered and reach the file when the buffer fills, on flush, or when the
+  // writer is destroyed.
+class ReplayWriter
+{
+  public:
+    ReplayWriter();
+    ~ReplayWriter();
+      // Start a new log, or append to an existing one; false if the file
+      // isn't a log of the current version
+    bool open(std::string filename);
+      // Append g's most recent game, played by the named createPlayer types
+      // (type1 moved first); false if it can't be encoded, as when a ship
+      // isn't straight, since a layout is logged as a cell and a direction
+    bool append(const Game& g, std::string type1, std::string type2);
+    bool append(const Game& g, const GameRecord& record,
+                std::string type1, std::string type2);
+    bool flush();
+      // We prevent a ReplayWriter object from being copied or assigned
+    ReplayWriter(const ReplayWriter&) = delete;
+    ReplayWriter& operator=(const ReplayWriter&) = delete;
+
+  private:
+    ReplayWriterImpl* m_impl;
+};
+
+  // One game in a mapped replay log.  It points into the mapping, so it is
+  // only valid while the ReplayReader that produced it stays open.
+class ReplayGame
+{
+  public:
+    ReplayGame() : m_data(nullptr), m_size(0) {}
+    unsigned seed() const;
+    int rows() const;
+    int cols() const;
+    int nShips() const;
+    int shipLength(int shipId) const;
+    char shipSymbol(int shipId) const;
+    int winner() const;
+      // player 0 moved first; "" if the writer didn't know the type
+    std::string playerType(int player) const;
+      // board 0 belongs to the player who moved first
+    bool shipPlacement(int board, int shipId, Point& topOrLeft, Direction& dir) const;
+    int nShots() const;
+    ShotRecord shot(int i) const;
+      // Copy the whole game out of the log
+    GameRecord toRecord() const;
+
+  private:
+    friend class ReplayReaderImpl;
+    size_t shipsOffset() const;
+    const unsigned char* m_data;
+    size_t m_size;
+};
+
+  // Maps a replay log read-only and walks its games in place
+class ReplayReader
+{
+  public:
+    ReplayReader();
+    ~ReplayReader();
+      // False if the file isn't a log of the current version
+    bool open(std::string filename);
+    bool next(ReplayGame& game);
+    void rewind();
+      // We prevent a ReplayReader object from being copied or assigned
+    ReplayReader(const ReplayReader&) = delete;
+    ReplayReader& operator=(const ReplayReader&) = delete;
+
+  private:
+    ReplayReaderImpl* m_impl;
+};
+
+#endif // REPLAYLOG_INCLUDED
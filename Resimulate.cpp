@@ -0,0 +1,218 @@
+#include "Resimulate.h"
+#include "ReplayLog.h"
+#include "StaticGame.h"
+#include "Game.h"
+#include "Board.h"
+#include "Player.h"
+#include "GameRecord.h"
+#include "OpponentModel.h"
+#include "globals.h"
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+  // Watches a re-simulated game and compares it with the log as it goes
+class ReplayChecker : public GameObserver
+{
+  public:
+    ReplayChecker(const Game& g, const ReplayGame& game, int stopAfter,
+                  bool show, ResimResult& result);
+    bool placed(const Board& b1, const Board& b2);
+    bool shot(const ShotRecord& s);
+  private:
+    bool mismatch(string detail);
+    void display() const;
+    const Game& m_game;
+    const ReplayGame& m_log;
+    int m_stopAfter;
+    bool m_show;
+    ResimResult& m_result;
+    const Board* m_boards[2];
+};
+
+ReplayChecker::ReplayChecker(const Game& g, const ReplayGame& game,
+                             int stopAfter, bool show, ResimResult& result)
+ : m_game(g), m_log(game), m_stopAfter(stopAfter), m_show(show),
+   m_result(result)
+{
+    m_boards[0] = nullptr;
+    m_boards[1] = nullptr;
+}
+
+bool ReplayChecker::mismatch(string detail)
+{
+    m_result.matched = false;
+    m_result.detail = detail;
+    return false;
+}
+
+void ReplayChecker::display() const
+{
+    for (int b = 0; b < 2; b++)
+    {
+        cout << "Board for " << m_log.playerType(b) << " player " << b+1
+             << " after " << m_result.shotsChecked << " shots:" << endl;
+        m_boards[b]->display(false);
+    }
+}
+
+bool ReplayChecker::placed(const Board& b1, const Board& b2)
+{
+    m_boards[0] = &b1;
+    m_boards[1] = &b2;
+    for (int b = 0; b < 2; b++)
+        for (int k = 0; k < m_game.nShips(); k++)
+        {
+            Point actual;
+            Direction actualDir;
+            Point logged;
+            Direction loggedDir;
+            if (!m_boards[b]->shipPlacement(k, actual, actualDir)  ||
+                !m_log.shipPlacement(b, k, logged, loggedDir)  ||
+                actual.r != logged.r  ||  actual.c != logged.c  ||
+                actualDir != loggedDir)
+                return mismatch("player " + to_string(b+1) + " placed the " +
+                                m_game.shipName(k) + " differently");
+        }
+    if (m_stopAfter == 0)
+    {
+        if (m_show)
+            display();
+        return false;
+    }
+    return true;
+}
+
+bool ReplayChecker::shot(const ShotRecord& s)
+{
+    int i = m_result.shotsChecked;
+    if (i >= m_log.nShots())
+    {
+        m_result.firstMismatch = i;
+        return mismatch("the game went on past the end of the log");
+    }
+
+    ShotRecord logged = m_log.shot(i);
+    bool hit = s.valid && s.shotHit;
+    bool destroyed = hit && s.shipDestroyed;
+    bool onBoard = m_game.isValid(s.p);
+    bool samePoint = (onBoard ? logged.p.r == s.p.r  &&  logged.p.c == s.p.c
+                              : logged.p.r < 0);
+    if (logged.player != s.player  ||  !samePoint  ||  logged.valid != s.valid  ||
+        logged.shotHit != hit  ||  logged.shipDestroyed != destroyed  ||
+        (destroyed  &&  logged.shipId != s.shipId))
+    {
+        m_result.firstMismatch = i;
+        return mismatch("shot " + to_string(i) + " by player " +
+                        to_string(s.player+1) + " at (" + to_string(s.p.r) +
+                        "," + to_string(s.p.c) + ") differs from the log's (" +
+                        to_string(logged.p.r) + "," + to_string(logged.p.c) + ")");
+    }
+
+    m_result.shotsChecked++;
+    if (m_stopAfter >= 0  &&  m_result.shotsChecked >= m_stopAfter)
+    {
+        if (m_show)
+            display();
+        return false;
+    }
+    return true;
+}
+
+ResimResult resimulate(const ReplayGame& game, int stopAfter, bool show,
+                       string type1, string type2)
+{
+    ResimResult result;
+    if (type1.empty())
+        type1 = game.playerType(0);
+    if (type2.empty())
+        type2 = game.playerType(1);
+
+    if (game.rows() < 1  ||  game.rows() > MAXROWS  ||
+        game.cols() < 1  ||  game.cols() > MAXCOLS)
+    {
+        result.matched = false;
+        result.detail = "the log has a bad board size";
+        return result;
+    }
+    if (type1 == "human"  ||  type2 == "human")
+    {
+        result.matched = false;
+        result.detail = "human players can't be re-simulated";
+        return result;
+    }
+
+    Game g(game.rows(), game.cols());
+    for (int k = 0; k < game.nShips(); k++)
+    {
+        string name = "ship ";
+        name += game.shipSymbol(k);
+        if (!g.addShip(game.shipLength(k), game.shipSymbol(k), name))
+        {
+            result.matched = false;
+            result.detail = "the log's fleet can't be rebuilt";
+            return result;
+        }
+    }
+
+    Player* p1 = createPlayer(type1, "Replay " + type1 + " 1", g);
+    Player* p2 = createPlayer(type2, "Replay " + type2 + " 2", g);
+    if (p1 == nullptr  ||  p2 == nullptr)
+    {
+        result.matched = false;
+        result.detail = "unknown player type";
+    }
+    else
+    {
+          // As in simulateGame, the players learn about each other in this
+          // game alone
+        OpponentModels models;
+        p1->setOpponentModels(&models);
+        p2->setOpponentModels(&models);
+          // Game::play starts each game's stream from its seed the same way
+        ReplayChecker checker(g, game, stopAfter, show, result);
+        seedRandInt(game.seed());
+        int winner = playStatic(g, *p1, *p2, checker);
+        if (winner >= 0  &&  result.matched)
+        {
+            if (winner != game.winner())
+            {
+                result.matched = false;
+                result.detail = "the game has a different winner";
+            }
+            else if (result.shotsChecked != game.nShots())
+            {
+                result.matched = false;
+                result.firstMismatch = result.shotsChecked;
+                result.detail = "the game ended before the log did";
+            }
+        }
+    }
+    delete p1;
+    delete p2;
+    return result;
+}
+
+int resimulateLog(string filename, int& nGames, string type1, string type2)
+{
+    ReplayReader reader;
+    if (!reader.open(filename))
+        return -1;
+
+    nGames = 0;
+    int nDiverged = 0;
+    ReplayGame game;
+    while (reader.next(game))
+    {
+        nGames++;
+        ResimResult result = resimulate(game, -1, false, type1, type2);
+        if (!result.matched)
+        {
+            nDiverged++;
+            cout << "Game " << nGames << " (seed " << game.seed()
+                 << ") diverged: " << result.detail << endl;
+        }
+    }
+    return nDiverged;
+}
@@ -0,0 +1,36 @@
+#ifndef RESIMULATE_INCLUDED
+#define RESIMULATE_INCLUDED
+
+#include <string>
+
+class ReplayGame;
+
+  // How a re-simulated game compared with its log
+struct ResimResult
+{
+    ResimResult() : matched(true), shotsChecked(0), firstMismatch(-1) {}
+    bool matched;        // every layout and shot checked agreed with the log
+    int shotsChecked;
+    int firstMismatch;   // index of the first shot that differed, or -1
+    std::string detail;  // what differed, if anything
+};
+
+  // Rebuild a logged game and play it again from its seed, checking both
+  // layouts and every Board::attack result against the log.  The logged
+  // player types are used unless type1/type2 name others, which is how a
+  // changed strategy is checked against old games.  With stopAfter >= 0 the
+  // game is fast-forwarded to that shot and stops there; if show is true,
+  // both boards are then displayed.  As in simulateGame, the players start
+  // with no opponent profiles, so a game logged from interactive play by a
+  // good player that had already learned about its opponent won't match.
+ResimResult resimulate(const ReplayGame& game, int stopAfter = -1,
+                       bool show = false, std::string type1 = "",
+                       std::string type2 = "");
+
+  // Re-simulate every game in a log without output, reporting each game that
+  // diverges.  Sets nGames to the number of games in the log and returns how
+  // many diverged, or -1 if the log can't be read.
+int resimulateLog(std::string filename, int& nGames, std::string type1 = "",
+                  std::string type2 = "");
+
+#endif // RESIMULATE_INCLUDED
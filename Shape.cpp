@@ -0,0 +1,278 @@
+#include "Shape.h"
+#include "Game.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+CellMask boardMask(int nRows, int nCols)
+{
+    CellMask row;
+    for (int c = 0; c < nCols  &&  c < MAXCOLS; c++)
+        row.set(c);
+    CellMask all;
+    for (int r = 0; r < nRows  &&  r < MAXROWS; r++)
+        all |= row << (r * MAXCOLS);
+    return all;
+}
+
+//******************** Straight footprints *****************************
+
+  // A CellMask as two words, since std::bitset can't be built bit by bit
+  // at compile time
+struct MaskWords
+{
+    uint64_t lo;
+    uint64_t hi;
+};
+
+static_assert(MAXROWS*MAXCOLS <= 128, "a footprint must fit in two words");
+
+const int MAXSTRAIGHT = (MAXROWS > MAXCOLS ? MAXROWS : MAXCOLS);
+
+struct StraightFootprints
+{
+      // [length][direction][corner cell]
+    MaskWords words[MAXSTRAIGHT+1][2][MAXROWS*MAXCOLS];
+};
+
+constexpr StraightFootprints makeStraightFootprints()
+{
+    StraightFootprints t = {};
+    for (int len = 1; len <= MAXSTRAIGHT; len++)
+        for (int dir = HORIZONTAL; dir <= VERTICAL; dir++)
+            for (int r = 0; r < MAXROWS; r++)
+                for (int c = 0; c < MAXCOLS; c++)
+                {
+                    if ((dir == HORIZONTAL ? c : r) + len > (dir == HORIZONTAL ? MAXCOLS : MAXROWS))
+                        continue;
+                    MaskWords& w = t.words[len][dir][r*MAXCOLS + c];
+                    for (int k = 0; k < len; k++)
+                    {
+                        int cell = (dir == VERTICAL ? r+k : r) * MAXCOLS + (dir == HORIZONTAL ? c+k : c);
+                        if (cell < 64)
+                            w.lo |= uint64_t(1) << cell;
+                        else
+                            w.hi |= uint64_t(1) << (cell - 64);
+                    }
+                }
+    return t;
+}
+
+static constexpr StraightFootprints straightFootprints = makeStraightFootprints();
+
+static CellMask toMask(const MaskWords& w)
+{
+    return (CellMask(w.hi) << 64) | CellMask(w.lo);
+}
+
+//******************** ShipShape ***************************************
+
+static bool rowMajor(const Point& a, const Point& b)
+{
+    return a.r < b.r  ||  (a.r == b.r  &&  a.c < b.c);
+}
+
+static bool samePoints(const vector<Point>& a, const vector<Point>& b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t k = 0; k < a.size(); k++)
+        if (a[k].r != b[k].r  ||  a[k].c != b[k].c)
+            return false;
+    return true;
+}
+
+ShipShape::ShipShape()
+ : m_size(1), m_straight(true)
+{
+    addStraightOrientations(1);
+}
+
+ShipShape ShipShape::straight(int length)
+{
+    ShipShape shape;
+    shape.m_orientations.clear();
+    shape.m_size = max(0, length);
+    shape.m_straight = true;
+    shape.addStraightOrientations(length);
+    return shape;
+}
+
+  // Both, even when they're the same, so a Direction is an orientation
+void ShipShape::addStraightOrientations(int length)
+{
+    for (int dir = HORIZONTAL; dir <= VERTICAL; dir++)
+    {
+        vector<Point> cells;
+        for (int k = 0; k < length; k++)
+            cells.push_back(dir == HORIZONTAL ? Point(0, k) : Point(k, 0));
+        if (length < 1  ||  length > MAXSTRAIGHT)
+        {
+            addOrientation(cells);
+            continue;
+        }
+        Orientation o;
+        o.cells = cells;
+        o.height = (dir == HORIZONTAL ? 1 : length);
+        o.width = (dir == HORIZONTAL ? length : 1);
+        o.footprints.resize(MAXROWS*MAXCOLS);
+        for (int cell = 0; cell < MAXROWS*MAXCOLS; cell++)
+            o.footprints[cell] = toMask(straightFootprints.words[length][dir][cell]);
+        m_orientations.push_back(o);
+    }
+}
+
+bool ShipShape::fromPicture(string picture, ShipShape& shape)
+{
+    vector<Point> cells;
+    int r = 0;
+    int c = 0;
+    for (size_t k = 0; k < picture.size(); k++)
+    {
+        char ch = picture[k];
+        if (ch == '/'  ||  ch == '\n')
+        {
+            r++;
+            c = 0;
+            continue;
+        }
+        if (ch != '.'  &&  ch != ' ')
+            cells.push_back(Point(r, c));
+        c++;
+    }
+    if (cells.empty())
+        return false;
+
+      // Flood from the first cell; every cell must be reached
+    vector<bool> reached(cells.size(), false);
+    vector<size_t> todo(1, 0);
+    reached[0] = true;
+    size_t nReached = 1;
+    while (!todo.empty())
+    {
+        Point p = cells[todo.back()];
+        todo.pop_back();
+        for (size_t k = 0; k < cells.size(); k++)
+        {
+            if (!reached[k]  &&  abs(cells[k].r - p.r) + abs(cells[k].c - p.c) == 1)
+            {
+                reached[k] = true;
+                nReached++;
+                todo.push_back(k);
+            }
+        }
+    }
+    if (nReached != cells.size())
+        return false;
+
+    int minR = cells[0].r, maxR = cells[0].r, minC = cells[0].c, maxC = cells[0].c;
+    for (size_t k = 1; k < cells.size(); k++)
+    {
+        minR = min(minR, cells[k].r);
+        maxR = max(maxR, cells[k].r);
+        minC = min(minC, cells[k].c);
+        maxC = max(maxC, cells[k].c);
+    }
+    if (max(maxR - minR, maxC - minC) >= min(MAXROWS, MAXCOLS))
+        return false;
+    if (minR == maxR  ||  minC == maxC)
+    {
+        shape = straight(cells.size());
+        return true;
+    }
+
+      // Four turns of the picture as drawn, then four of its mirror image
+    ShipShape result;
+    result.m_orientations.clear();
+    result.m_size = cells.size();
+    result.m_straight = false;
+    for (int t = 0; t < 8; t++)
+    {
+        vector<Point> turned;
+        for (size_t k = 0; k < cells.size(); k++)
+        {
+            Point p(cells[k].r, t < 4 ? cells[k].c : -cells[k].c);
+            for (int q = 0; q < t % 4; q++)
+                p = Point(p.c, -p.r);
+            turned.push_back(p);
+        }
+        result.addOrientation(turned);
+    }
+    shape = result;
+    return true;
+}
+
+  // Move the cells so their bounding box starts at (0,0) and add them as
+  // a new orientation, unless this one is already there
+void ShipShape::addOrientation(vector<Point> cells)
+{
+    Orientation o;
+    o.height = 0;
+    o.width = 0;
+    if (!cells.empty())
+    {
+        int minR = cells[0].r;
+        int minC = cells[0].c;
+        for (size_t k = 1; k < cells.size(); k++)
+        {
+            minR = min(minR, cells[k].r);
+            minC = min(minC, cells[k].c);
+        }
+        for (size_t k = 0; k < cells.size(); k++)
+        {
+            cells[k].r -= minR;
+            cells[k].c -= minC;
+            o.height = max(o.height, cells[k].r + 1);
+            o.width = max(o.width, cells[k].c + 1);
+        }
+    }
+    sort(cells.begin(), cells.end(), rowMajor);
+    if (!m_straight)
+    {
+        for (size_t k = 0; k < m_orientations.size(); k++)
+            if (samePoints(m_orientations[k].cells, cells))
+                return;
+    }
+    o.footprints.resize(MAXROWS*MAXCOLS);
+    for (int r = 0; r + o.height <= MAXROWS; r++)
+        for (int c = 0; c + o.width <= MAXCOLS; c++)
+        {
+            CellMask& footprint = o.footprints[cellIndex(Point(r, c))];
+            for (size_t k = 0; k < cells.size(); k++)
+                footprint.set(cellIndex(Point(r + cells[k].r, c + cells[k].c)));
+        }
+    o.cells = cells;
+    m_orientations.push_back(o);
+}
+
+bool ShipShape::fits(int orientation, Point topLeft, int nRows, int nCols) const
+{
+    if (orientation < 0  ||  orientation >= nOrientations())
+        return false;
+    const Orientation& o = m_orientations[orientation];
+    return topLeft.r >= 0  &&  topLeft.c >= 0  &&
+           topLeft.r + o.height <= nRows  &&  topLeft.c + o.width <= nCols;
+}
+
+string ShipShape::picture(int orientation) const
+{
+    const Orientation& o = m_orientations[orientation];
+    string rows(o.height * (o.width + 1), '.');
+    for (int r = 0; r < o.height; r++)
+        rows[r * (o.width + 1) + o.width] = '\n';
+    for (size_t k = 0; k < o.cells.size(); k++)
+        rows[o.cells[k].r * (o.width + 1) + o.cells[k].c] = 'X';
+    return rows;
+}
+
+bool hasShapedShips(const Game& g)
+{
+    for (int k = 0; k < g.nShips(); k++)
+        if (!g.shipShape(k).isStraight())
+            return true;
+    return false;
+}
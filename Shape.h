@@ -0,0 +1,88 @@
+#ifndef SHAPE_INCLUDED
+#define SHAPE_INCLUDED
+
+#include "globals.h"
+#include <bitset>
+#include <string>
+#include <vector>
+
+class Game;
+
+  // A set of cells of a board, cell (r,c) being bit r*MAXCOLS + c.  A mask
+  // shifted left by r*MAXCOLS + c moves every cell down r rows and right c
+  // columns, so a shape worked out once at the corner can be tried anywhere.
+typedef std::bitset<MAXROWS*MAXCOLS> CellMask;
+
+inline int cellIndex(Point p)
+{
+    return p.r * MAXCOLS + p.c;
+}
+
+  // The cells of a board with nRows rows and nCols columns
+CellMask boardMask(int nRows, int nCols);
+
+  // The shape of a ship: a polyomino whose every distinct rotation and
+  // reflection is worked out once, as a list of cells and as a mask with
+  // the top left corner of its bounding box at (0,0).  A ship is placed by
+  // naming one of these orientations and the board cell that corner goes
+  // on, which need not be one of the ship's cells.
+  //
+  // A straight ship has exactly two orientations, HORIZONTAL and VERTICAL
+  // in that order (even a ship of length 1), so a Direction is also an
+  // orientation and straight fleets play exactly as they always have.
+  //
+  // Every orientation's footprint at every corner cell is in a table, so
+  // checking a placement is a lookup and an AND.  Straight ships, which
+  // make up the standard fleets, copy theirs from a table generated at
+  // compile time; other shapes build theirs once, when they're made.
+class ShipShape
+{
+  public:
+    ShipShape();        // a single cell
+    static ShipShape straight(int length);
+      // From a picture with rows separated by '/' or newlines, a cell
+      // being any character other than '.' or a space, e.g. "X./X./XX"
+      // for an L.  Returns false if the picture has no cells, isn't one
+      // connected piece or won't fit within MAXROWS by MAXCOLS.
+    static bool fromPicture(std::string picture, ShipShape& shape);
+
+    int size() const { return m_size; }
+    bool isStraight() const { return m_straight; }
+    int nOrientations() const { return m_orientations.size(); }
+    int height(int orientation) const { return m_orientations[orientation].height; }
+    int width(int orientation) const { return m_orientations[orientation].width; }
+      // The cells of an orientation, in row-major order, relative to the
+      // corner of its bounding box
+    const std::vector<Point>& cells(int orientation) const
+        { return m_orientations[orientation].cells; }
+      // Whether the ship lies wholly on an nRows by nCols board with the
+      // corner of its bounding box at topLeft
+    bool fits(int orientation, Point topLeft, int nRows, int nCols) const;
+      // The cells it covers there, looked up rather than worked out; only
+      // meaningful if it fits
+    const CellMask& maskAt(int orientation, Point topLeft) const
+        { return m_orientations[orientation].footprints[cellIndex(topLeft)]; }
+      // The orientation drawn one row per line
+    std::string picture(int orientation) const;
+
+  private:
+    struct Orientation
+    {
+        std::vector<Point> cells;
+        int height;
+        int width;
+          // The cells covered with the corner at each cell of a MAXROWS by
+          // MAXCOLS grid, or none where it would run off the grid
+        std::vector<CellMask> footprints;
+    };
+    void addOrientation(std::vector<Point> cells);
+    void addStraightOrientations(int length);
+    std::vector<Orientation> m_orientations;
+    int m_size;
+    bool m_straight;
+};
+
+  // Whether any ship of g's fleet isn't straight
+bool hasShapedShips(const Game& g);
+
+#endif // SHAPE_INCLUDED
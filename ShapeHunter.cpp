@@ -0,0 +1,224 @@
+#include "ShapeHunter.h"
+#include "Game.h"
+#include "KnowledgeCache.h"
+#include "PackedState.h"
+#include "Shape.h"
+#include "globals.h"
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+ShapeHunter::ShapeHunter(const Game& g)
+ : m_game(g), m_hash(g), sunk(g.nShips(), false)
+{}
+
+void ShapeHunter::record(Point p, bool shotHit, bool shipDestroyed, int shipId)
+{
+    int cell = cellIndex(p);
+    shot.set(cell);
+    if (!shotHit)
+    {
+        missed.set(cell);
+        dead.set(cell);
+        m_hash.miss(p);
+        return;
+    }
+    openHits.set(cell);
+    m_hash.hit(p);
+    if (!shipDestroyed || shipId < 0 || shipId >= m_game.nShips())
+    {
+        return;
+    }
+    
+    //the sunk ship lies on hits only and through this one; take the first placement that does
+    sunk[shipId] = true;
+    m_hash.sink(shipId);
+    const ShipShape& shape = m_game.shipShape(shipId);
+    for (int o=0; o<shape.nOrientations(); o++)
+    {
+        for (int r=max(0, p.r-shape.height(o)+1); r<=p.r; r++)
+        {
+            for (int c=max(0, p.c-shape.width(o)+1); c<=p.c; c++)
+            {
+                if (!shape.fits(o, Point(r, c), m_game.rows(), m_game.cols()))
+                {
+                    continue;
+                }
+                CellMask cells = shape.maskAt(o, Point(r, c));
+                if (cells.test(cell) && (cells & ~openHits).none())
+                {
+                    openHits &= ~cells;
+                    dead |= cells;
+                    const vector<Point>& shipCells = shape.cells(o);
+                    for (int i=0; i<(int)shipCells.size(); i++)
+                    {
+                        m_hash.sunkCell(Point(r+shipCells[i].r, c+shipCells[i].c));
+                    }
+                    return;
+                }
+            }
+        }
+    }
+}
+
+bool ShapeHunter::bestCell(Point& p, const CellMask& pending) const
+{
+    //the same knowledge always gives the same weights, so in the opening, and whenever play comes back
+    //to a position seen before, the count is looked up instead of redone; the hash doesn't name the
+    //rest of a volley, so picks after a volley's first are always counted afresh
+    vector<int> best;
+    if (pending.any())
+    {
+        heaviestCells(best, pending);
+    }
+    else if (!knowledgeCache().find(m_hash.value(), best))
+    {
+        heaviestCells(best, pending);
+        knowledgeCache().store(m_hash.value(), best);
+    }
+    if (best.empty())
+    {
+        return false;
+    }
+    int cell = best[best.size() > 1 ? randInt(best.size()) : 0]; //ties broken at random
+    p = Point(cell / MAXCOLS, cell % MAXCOLS);
+    return true;
+}
+
+//every unshot cell not pending of the greatest weight, in row-major order
+void ShapeHunter::heaviestCells(vector<int>& best, const CellMask& pending) const
+{
+    CellMask taken = shot | pending;
+    best.clear();
+    int weight[MAXROWS*MAXCOLS] = { 0 };
+    bool any = false;
+    for (int pass=0; pass<2 && !any; pass++)
+    {
+        bool needHit = (pass == 0 && chasing()); //if no placement explains the open hits, fall back to all of them
+        for (int k=0; k<m_game.nShips(); k++)
+        {
+            if (sunk[k])
+            {
+                continue;
+            }
+            const ShipShape& shape = m_game.shipShape(k);
+            for (int o=0; o<shape.nOrientations(); o++)
+            {
+                const vector<Point>& cells = shape.cells(o);
+                for (int r=0; r+shape.height(o)<=m_game.rows(); r++)
+                {
+                    for (int c=0; c+shape.width(o)<=m_game.cols(); c++)
+                    {
+                        CellMask placement = shape.maskAt(o, Point(r, c));
+                        if ((placement & dead).any() || (placement & ~taken).none())
+                        {
+                            continue;
+                        }
+                        int w = (needHit ? (int)(placement & openHits).count() : 1);
+                        if (w == 0)
+                        {
+                            continue;
+                        }
+                        for (int i=0; i<(int)cells.size(); i++)
+                        {
+                            int cell = cellIndex(Point(r+cells[i].r, c+cells[i].c));
+                            if (!taken.test(cell))
+                            {
+                                weight[cell] += w;
+                                any = true;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    if (!any)
+    {
+        return;
+    }
+    
+    int heaviest = *max_element(weight, weight + MAXROWS*MAXCOLS);
+    for (int cell=0; cell<MAXROWS*MAXCOLS; cell++)
+    {
+        if (weight[cell] == heaviest)
+        {
+            best.push_back(cell);
+        }
+    }
+}
+
+bool ShapeHunter::pack(PackedKnowledge& packed) const
+{
+    if (m_game.nShips() > MAXKNOWNSHIPS)
+    {
+        return false;
+    }
+    packed = PackedKnowledge();
+    for (int cell=0; cell<MAXROWS*MAXCOLS; cell++)
+    {
+        if (!shot.test(cell))
+        {
+            continue;
+        }
+        CellKnowledge k = (missed.test(cell) ? MISSED_CELL : openHits.test(cell) ? HIT_CELL : SUNK_CELL);
+        setKnowledgeAt(packed, Point(cell / MAXCOLS, cell % MAXCOLS), k);
+    }
+    for (int k=0; k<m_game.nShips(); k++)
+    {
+        if (sunk[k])
+        {
+            setKnownSunk(packed, k);
+        }
+    }
+    return true;
+}
+
+bool ShapeHunter::unpack(const PackedKnowledge& packed)
+{
+    if (m_game.nShips() > MAXKNOWNSHIPS)
+    {
+        return false;
+    }
+    
+    //a Zobrist hash is the XOR of its facts, so putting them back in any order rebuilds it exactly
+    m_hash = KnowledgeHash(m_game);
+    shot.reset();
+    missed.reset();
+    dead.reset();
+    openHits.reset();
+    for (int cell=0; cell<MAXROWS*MAXCOLS; cell++)
+    {
+        Point p(cell / MAXCOLS, cell % MAXCOLS);
+        switch (knowledgeAt(packed, p))
+        {
+            case UNKNOWN_CELL:
+                continue;
+            case MISSED_CELL:
+                missed.set(cell);
+                dead.set(cell);
+                m_hash.miss(p);
+                break;
+            case HIT_CELL:
+                openHits.set(cell);
+                m_hash.hit(p);
+                break;
+            case SUNK_CELL:
+                dead.set(cell);
+                m_hash.hit(p);
+                m_hash.sunkCell(p);
+                break;
+        }
+        shot.set(cell);
+    }
+    for (int k=0; k<m_game.nShips(); k++)
+    {
+        sunk[k] = knownSunk(packed, k);
+        if (sunk[k])
+        {
+            m_hash.sink(k);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef SHAPEHUNTER_INCLUDED
+#define SHAPEHUNTER_INCLUDED
+
+#include "KnowledgeCache.h"
+#include "PackedState.h"
+#include "Shape.h"
+#include "globals.h"
+#include <vector>
+
+class Game;
+
+  // What a computer player has learned about the opponent's board, kept as
+  // cell sets.  Probing outward from a hit along rows and columns only
+  // works for straight ships, so with shaped ships in the fleet the players
+  // instead weigh every way each ship still afloat could lie, given the
+  // shots so far.
+class ShapeHunter
+{
+  public:
+    ShapeHunter(const Game& g);
+    void record(Point p, bool shotHit, bool shipDestroyed, int shipId);
+      // A hit not yet explained by a sunk ship
+    bool chasing() const { return openHits.any(); }
+      // The unshot cell covered by the most placements that agree with the
+      // shots so far, counting only placements through an unexplained hit
+      // while there are any; false if no placement is left.  Cells in
+      // pending, already chosen for the same volley, are never chosen and
+      // add no weight, as if shot.
+    bool bestCell(Point& p, const CellMask& pending = CellMask()) const;
+      // What's been learned, in 32 bytes, and back again; a hunter unpacked
+      // from what another packed chooses exactly as that one would.  Both
+      // return false if the fleet has more than MAXKNOWNSHIPS ships.
+    bool pack(PackedKnowledge& packed) const;
+    bool unpack(const PackedKnowledge& packed);
+
+  private:
+    void heaviestCells(std::vector<int>& best, const CellMask& pending) const;
+    const Game& m_game;
+      // Names what we know, so the heaviest cells can be shared with other
+      // games
+    KnowledgeHash m_hash;
+    CellMask shot;      // cells we've attacked
+    CellMask missed;
+    CellMask dead;      // misses and the cells of sunk ships, where no ship afloat can be
+    CellMask openHits;
+    std::vector<bool> sunk;
+};
+
+#endif // SHAPEHUNTER_INCLUDED
@@ -0,0 +1,332 @@
+#include "ShardedLeague.h"
+#include "League.h"
+#include "OpponentModel.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+  // Checkpoint file format, every integer in native byte order, since the
+  // shards that read a checkpoint run where it was written:
+  //   "BSSH", u32 version, u64 league fingerprint,
+  //   u32 shard, u32 firstGame, u32 lastGame, u32 nextGame,
+  //   u32 nVariants, u32 nTypes,
+  //   i64 wins[nVariants][nTypes][nTypes], i64 unfinished,
+  //   then each pairing's opponent profiles as OpponentModels::save
+  //   writes them, pairings in the order the shard plays them
+  // nextGame is the first game number not yet counted; the shard is done
+  // when it reaches lastGame.  Version 1 checkpoints had no profiles.
+const char SHARD_MAGIC[4] = { 'B', 'S', 'S', 'H' };
+const uint32_t SHARD_VERSION = 2;
+
+  // Game numbers played between checkpoints
+const int CHECKPOINT_INTERVAL = 10;
+
+  // Where a shard's progress stands.  Each pairing carries its profiles
+  // across the shard's games, so a resumed shard plays what it would have.
+struct ShardState
+{
+    uint32_t firstGame;
+    uint32_t lastGame;
+    uint32_t nextGame;
+    LeagueResult result;
+    vector<unique_ptr<OpponentModels>> models;    // by pairing
+};
+
+  // Empty profiles for every pairing on every variant
+static void startModels(const LeagueSpec& spec, ShardState& state)
+{
+    int n = spec.types.size();
+    state.models.clear();
+    for (size_t k = 0; k < spec.variants.size() * n * (n-1) / 2; k++)
+        state.models.emplace_back(new OpponentModels);
+}
+
+static string checkpointName(string prefix, int shard)
+{
+    return prefix + "." + to_string(shard) + ".shard";
+}
+
+static void shardRange(const LeagueSpec& spec, int nShards, int shard,
+                       uint32_t& first, uint32_t& last)
+{
+    long long games = spec.gamesPerPairing;
+    first = games * shard / nShards;
+    last = games * (shard + 1) / nShards;
+}
+
+  // FNV-1a over everything that decides which games a league plays, so a
+  // checkpoint from a different league isn't mistaken for progress
+static void mix(uint64_t& h, const void* data, size_t size)
+{
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t k = 0; k < size; k++)
+    {
+        h ^= p[k];
+        h *= 0x100000001b3ULL;
+    }
+}
+
+static void mix(uint64_t& h, string s)
+{
+    uint32_t size = s.size();
+    mix(h, &size, sizeof(size));
+    mix(h, s.data(), s.size());
+}
+
+static uint64_t fingerprint(const LeagueSpec& spec, int nShards)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t k = 0; k < spec.types.size(); k++)
+        mix(h, spec.types[k]);
+    for (size_t v = 0; v < spec.variants.size(); v++)
+    {
+        const LeagueVariant& var = spec.variants[v];
+        mix(h, var.name);
+        int32_t dims[2] = { var.rows, var.cols };
+        mix(h, dims, sizeof(dims));
+        for (size_t k = 0; k < var.fleet.size(); k++)
+        {
+            int32_t length = var.fleet[k].length;
+            mix(h, &length, sizeof(length));
+            mix(h, &var.fleet[k].symbol, 1);
+              // A shaped ship's length is 0, so its picture tells it apart
+            mix(h, var.fleet[k].picture);
+        }
+    }
+    int32_t rest[3] = { spec.gamesPerPairing, (int32_t)spec.firstSeed, nShards };
+    mix(h, rest, sizeof(rest));
+    return h;
+}
+
+template <class T>
+static void put(ofstream& out, T x)
+{
+    out.write(reinterpret_cast<const char*>(&x), sizeof(x));
+}
+
+template <class T>
+static bool get(ifstream& in, T& x)
+{
+    return bool(in.read(reinterpret_cast<char*>(&x), sizeof(x)));
+}
+
+  // Make sure what's been written to a file, or the entries of a
+  // directory, are on the disk
+static bool syncPath(string path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    bool synced = (fsync(fd) == 0);
+    close(fd);
+    return synced;
+}
+
+  // Write to a scratch file and rename it over the old checkpoint, so a
+  // shard killed mid-write still leaves the previous checkpoint whole.  The
+  // scratch file reaches the disk before the rename does, so a crash can't
+  // leave the new name on an empty or partly written file.
+static bool saveCheckpoint(string filename, const LeagueSpec& spec,
+                           uint64_t print, int shard, const ShardState& state)
+{
+    string scratch = filename + ".tmp";
+    {
+        ofstream out(scratch, ios::binary | ios::trunc);
+        if (!out)
+            return false;
+        uint32_t nVariants = spec.variants.size();
+        uint32_t nTypes = spec.types.size();
+        out.write(SHARD_MAGIC, 4);
+        put(out, SHARD_VERSION);
+        put(out, print);
+        put(out, uint32_t(shard));
+        put(out, state.firstGame);
+        put(out, state.lastGame);
+        put(out, state.nextGame);
+        put(out, nVariants);
+        put(out, nTypes);
+        for (uint32_t v = 0; v < nVariants; v++)
+            for (uint32_t i = 0; i < nTypes; i++)
+                for (uint32_t j = 0; j < nTypes; j++)
+                    put(out, int64_t(state.result.wins(v, i, j)));
+        put(out, int64_t(state.result.unfinished()));
+        for (size_t k = 0; k < state.models.size(); k++)
+        {
+            if (!state.models[k]->save(out))
+                return false;
+        }
+        if (!out.flush())
+            return false;
+    }
+    if (!syncPath(scratch)  ||  rename(scratch.c_str(), filename.c_str()) != 0)
+        return false;
+    string::size_type slash = filename.rfind('/');
+    return syncPath(slash == string::npos ? "." : filename.substr(0, slash + 1));
+}
+
+  // False if there's no usable checkpoint for this shard of this league
+static bool loadCheckpoint(string filename, const LeagueSpec& spec,
+                           uint64_t print, int shard, ShardState& state)
+{
+    ifstream in(filename, ios::binary);
+    char magic[4];
+    uint32_t version;
+    uint64_t savedPrint;
+    uint32_t savedShard;
+    uint32_t nVariants;
+    uint32_t nTypes;
+    if (!in.read(magic, 4)  ||  !equal(magic, magic+4, SHARD_MAGIC)  ||
+        !get(in, version)  ||  version != SHARD_VERSION  ||
+        !get(in, savedPrint)  ||  savedPrint != print  ||
+        !get(in, savedShard)  ||  savedShard != uint32_t(shard)  ||
+        !get(in, state.firstGame)  ||  !get(in, state.lastGame)  ||
+        !get(in, state.nextGame)  ||  !get(in, nVariants)  ||
+        !get(in, nTypes)  ||  nVariants != spec.variants.size()  ||
+        nTypes != spec.types.size()  ||  state.nextGame < state.firstGame  ||
+        state.nextGame > state.lastGame)
+        return false;
+
+      // The counts go in one cell at a time, each as a pairing with no
+      // games the other way
+    state.result.start(spec);
+    for (uint32_t v = 0; v < nVariants; v++)
+        for (uint32_t i = 0; i < nTypes; i++)
+            for (uint32_t j = 0; j < nTypes; j++)
+            {
+                int64_t wins;
+                if (!get(in, wins))
+                    return false;
+                state.result.addGames(v, i, j, wins, 0, 0);
+            }
+    int64_t unfinished;
+    if (!get(in, unfinished))
+        return false;
+    state.result.addGames(0, 0, 0, 0, 0, unfinished);
+    startModels(spec, state);
+    for (size_t k = 0; k < state.models.size(); k++)
+    {
+        if (!state.models[k]->load(in))
+            return false;
+    }
+    return true;
+}
+
+bool runShard(const LeagueSpec& spec, int nShards, int shard,
+              string checkpointPrefix)
+{
+    if (!validLeague(spec)  ||  nShards < 1  ||  shard < 0  ||  shard >= nShards)
+        return false;
+
+    uint64_t print = fingerprint(spec, nShards);
+    string filename = checkpointName(checkpointPrefix, shard);
+    ShardState state;
+    if (!loadCheckpoint(filename, spec, print, shard, state))
+    {
+        shardRange(spec, nShards, shard, state.firstGame, state.lastGame);
+        state.nextGame = state.firstGame;
+        state.result.start(spec);
+        startModels(spec, state);
+    }
+
+    int n = spec.types.size();
+    while (state.nextGame < state.lastGame)
+    {
+        uint32_t stop = min(state.lastGame, state.nextGame + CHECKPOINT_INTERVAL);
+        size_t pairing = 0;
+        for (size_t v = 0; v < spec.variants.size(); v++)
+            for (int i = 0; i < n; i++)
+                for (int j = i+1; j < n; j++)
+                    playPairing(spec, v, i, j, state.nextGame, stop,
+                                *state.models[pairing++], state.result);
+        state.nextGame = stop;
+        if (!saveCheckpoint(filename, spec, print, shard, state))
+            return false;
+    }
+      // An empty shard still leaves a checkpoint saying it's done
+    return saveCheckpoint(filename, spec, print, shard, state);
+}
+
+bool runShardedLeague(const LeagueSpec& spec, int nShards, int nProcesses,
+                      string checkpointPrefix, LeagueResult& result)
+{
+    if (!validLeague(spec)  ||  nShards < 1)
+        return false;
+    if (nProcesses < 1)
+        nProcesses = 1;
+    uint64_t print = fingerprint(spec, nShards);
+
+    vector<int> pending;
+    for (int s = 0; s < nShards; s++)
+    {
+        ShardState state;
+        if (!loadCheckpoint(checkpointName(checkpointPrefix, s), spec, print,
+                            s, state)  ||  state.nextGame < state.lastGame)
+            pending.push_back(s);
+    }
+
+      // Whatever is buffered would otherwise be written once per child too
+    cout.flush();
+    fflush(nullptr);
+
+    set<pid_t> running;
+    size_t launched = 0;
+    while (launched < pending.size()  ||  !running.empty())
+    {
+        if (launched < pending.size()  &&  (int)running.size() < nProcesses)
+        {
+            int s = pending[launched];
+            pid_t pid = fork();
+            if (pid == 0)
+                _exit(runShard(spec, nShards, s, checkpointPrefix) ? 0 : 1);
+            if (pid > 0)
+            {
+                running.insert(pid);
+                launched++;
+                continue;
+            }
+            if (running.empty())
+            {
+                  // Can't fork and nothing to wait for, so play it here
+                runShard(spec, nShards, s, checkpointPrefix);
+                launched++;
+                continue;
+            }
+              // Otherwise try again once a child has finished
+        }
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid > 0)
+            running.erase(pid);
+        else
+            running.clear();
+    }
+
+    bool complete = true;
+    result.start(spec);
+    for (int s = 0; s < nShards; s++)
+    {
+        ShardState state;
+        if (!loadCheckpoint(checkpointName(checkpointPrefix, s), spec, print,
+                            s, state))
+        {
+            complete = false;
+            continue;
+        }
+        if (state.nextGame < state.lastGame)
+            complete = false;
+        result.merge(state.result);
+    }
+    return complete;
+}
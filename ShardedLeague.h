@@ -0,0 +1,31 @@
+#ifndef SHARDEDLEAGUE_INCLUDED
+#define SHARDEDLEAGUE_INCLUDED
+
+#include <string>
+
+struct LeagueSpec;
+class LeagueResult;
+
+  // Play shard number shard of nShards: games first through last-1 of every
+  // pairing on every variant, where the shards split the game numbers into
+  // nearly equal ranges.  Results are checkpointed to
+  // checkpointPrefix.<shard>.shard as the shard goes.  If that file already
+  // holds progress for the same league, the shard picks up after it.  Each
+  // pairing carries one set of opponent profiles through the shard's games,
+  // saved with the checkpoint, so the shard plays the same games however
+  // often it's interrupted, though not those runLeague would play, since
+  // the profiles start empty at the shard's first game.
+  // Returns false if the league is invalid or the checkpoint can't be written.
+bool runShard(const LeagueSpec& spec, int nShards, int shard,
+              std::string checkpointPrefix);
+
+  // Play the league as nShards shards in up to nProcesses child processes
+  // at once, then merge every shard's checkpoint into result.  Shards whose
+  // checkpoints show them finished are not run again, so rerunning after an
+  // interruption only plays what was left.  spec.nThreads is ignored; each
+  // shard plays on one thread.  Returns false if the league is invalid or
+  // some shard didn't finish, in which case result holds the finished part.
+bool runShardedLeague(const LeagueSpec& spec, int nShards, int nProcesses,
+                      std::string checkpointPrefix, LeagueResult& result);
+
+#endif // SHARDEDLEAGUE_INCLUDED
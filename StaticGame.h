@@ -0,0 +1,144 @@
+#ifndef STATICGAME_INCLUDED
+#define STATICGAME_INCLUDED
+
+#include "Game.h"
+#include "Board.h"
+#include "GameRecord.h"
+#include "globals.h"
+
+  // An observer places each fleet (normally by asking its player), sees both
+  // boards once the ships are placed and then every shot as the engine
+  // resolves it; returning false from placed or shot stops the game.
+  // Observers derive from GameObserver and hide the members they change;
+  // GameObserver itself watches nothing and compiles away.
+struct GameObserver
+{
+    template <class P>
+    bool placeShips(P& p, Board& b, int /* player */) { return p.placeShips(b); }
+    bool placed(const Board& /* b1 */, const Board& /* b2 */) { return true; }
+    bool shot(const ShotRecord& /* s */) { return true; }
+};
+
+typedef GameObserver NullObserver;
+
+  // Fills in a GameRecord the way Game::play does, except for the seed,
+  // which the caller chose
+struct RecordObserver : public GameObserver
+{
+    RecordObserver(const Game& g, GameRecord& r) : game(g), record(r) {}
+    bool placed(const Board& b1, const Board& b2)
+    {
+        for (int k = 0; k < game.nShips(); k++)
+        {
+            ShipPlacement s1;
+            ShipPlacement s2;
+            b1.shipPlacement(k, s1.topOrLeft, s1.orientation);
+            b2.shipPlacement(k, s2.topOrLeft, s2.orientation);
+            record.layouts[0].push_back(s1);
+            record.layouts[1].push_back(s2);
+        }
+        return true;
+    }
+    bool shot(const ShotRecord& s)
+    {
+        record.addShot(s.player, s.p, s.valid, s.shotHit, s.shipDestroyed, s.shipId);
+        return true;
+    }
+    const Game& game;
+    GameRecord& record;
+};
+
+  // Records the game and applies a GameSetup: preset layouts replace the
+  // players' own placement, and the stream can restart once both fleets
+  // are down
+struct SetupObserver : public RecordObserver
+{
+    SetupObserver(const Game& g, GameRecord& r, const GameSetup& s)
+     : RecordObserver(g, r), setup(s)
+    {}
+    template <class P>
+    bool placeShips(P& p, Board& b, int player)
+    {
+        const std::vector<ShipPlacement>* layout = setup.layouts[player];
+        if (layout == nullptr)
+            return p.placeShips(b);
+        for (int k = 0; k < game.nShips(); k++)
+        {
+            if (k >= (int)layout->size()  ||
+                !b.placeShip((*layout)[k].topOrLeft, k, (*layout)[k].orientation))
+                return false;
+        }
+        return true;
+    }
+    bool placed(const Board& b1, const Board& b2)
+    {
+        if (setup.reseedAttacks)
+            seedRandInt(setup.attackSeed);
+        return RecordObserver::placed(b1, b2);
+    }
+    const GameSetup& setup;
+};
+
+  // The same game as Game::play, with no output or pauses, compiled for one
+  // pair of player types.  When P1 and P2 are final classes whose member
+  // functions are visible, every call below is direct and can be inlined.
+  // Returns 1 or 2 for the winner, 0 if a player couldn't place its ships,
+  // or -1 if the observer stopped the game.
+template <class P1, class P2, class Observer>
+int playStatic(const Game& g, P1& p1, P2& p2, Observer& obs)
+{
+    Board b1(g);
+    Board b2(g);
+
+    p1.recordOpponent(p2.name());
+    p2.recordOpponent(p1.name());
+    if (!obs.placeShips(p1, b1, 0)  ||  !obs.placeShips(p2, b2, 1))
+        return 0;
+    if (!obs.placed(b1, b2))
+        return -1;
+
+    ShotRecord s;
+    for (;;)
+    {
+        s.player = 0;
+        s.p = p1.recommendAttack();
+        s.shotHit = false;
+        s.shipDestroyed = false;
+        s.shipId = 100;
+        s.valid = b2.attack(s.p, s.shotHit, s.shipDestroyed, s.shipId);
+        if (s.valid)
+        {
+            p1.recordAttackResult(s.p, true, s.shotHit, s.shipDestroyed, s.shipId);
+            p2.recordAttackByOpponent(s.p);
+        }
+        if (!obs.shot(s))
+            return -1;
+        if (s.valid  &&  b2.allShipsDestroyed())
+            return 1;
+
+        s.player = 1;
+        s.p = p2.recommendAttack();
+        s.shotHit = false;
+        s.shipDestroyed = false;
+        s.shipId = 100;
+        s.valid = b1.attack(s.p, s.shotHit, s.shipDestroyed, s.shipId);
+        if (s.valid)
+        {
+            p2.recordAttackResult(s.p, true, s.shotHit, s.shipDestroyed, s.shipId);
+            p1.recordAttackByOpponent(s.p);
+        }
+        if (!obs.shot(s))
+            return -1;
+        if (s.valid  &&  b1.allShipsDestroyed())
+            return 2;
+    }
+}
+
+template <class P1, class P2>
+int playStatic(const Game& g, P1& p1, P2& p2)
+{
+    NullObserver obs;
+    return playStatic(g, p1, p2, obs);
+}
+
+#endif // STATICGAME_INCLUDED
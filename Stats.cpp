@@ -0,0 +1,391 @@
+#include "Stats.h"
+#include "GameRecord.h"
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+const double Z95 = 1.96;
+
+//******************** RunningMoments **********************************
+
+void RunningMoments::add(double x)
+{
+      // Welford's update keeps the variance accurate over long runs
+    m_n++;
+    double delta = x - m_mean;
+    m_mean += delta / m_n;
+    m_m2 += delta * (x - m_mean);
+}
+
+void RunningMoments::merge(const RunningMoments& other)
+{
+    if (other.m_n == 0)
+        return;
+    if (m_n == 0)
+    {
+        *this = other;
+        return;
+    }
+    long long n = m_n + other.m_n;
+    double delta = other.m_mean - m_mean;
+    m_mean += delta * other.m_n / n;
+    m_m2 += other.m_m2 + delta * delta * m_n * other.m_n / n;
+    m_n = n;
+}
+
+double RunningMoments::variance() const
+{
+    return m_n > 1 ? m_m2 / (m_n - 1) : 0;
+}
+
+double RunningMoments::confidence() const
+{
+    return m_n > 1 ? Z95 * sqrt(variance() / m_n) : 0;
+}
+
+//******************** GameStats ***************************************
+
+GameStats::GameStats()
+ : m_games(0), m_unfinished(0), m_type1Wins(0), m_type2Wins(0),
+   m_firstMoverWins(0)
+{
+    for (int k = 0; k < NBUCKETS; k++)
+        m_shotsToWinHistogram[k] = 0;
+}
+
+void GameStats::add(const GameRecord& record, bool type1First)
+{
+    m_games++;
+
+    int shotsFired[2] = { 0, 0 };
+    int wasted = 0;
+    for (size_t i = 0; i < record.shots.size(); i++)
+    {
+        const ShotRecord& s = record.shots[i];
+        shotsFired[s.player]++;
+        if (!s.valid)
+            wasted++;
+        if (s.shipDestroyed)
+        {
+            if (s.shipId >= (int)m_timeToSink.size())
+                m_timeToSink.resize(s.shipId + 1);
+            m_timeToSink[s.shipId].add(shotsFired[s.player]);
+        }
+    }
+    m_wasted.add(wasted);
+
+    if (record.winner != 1  &&  record.winner != 2)
+    {
+        m_unfinished++;
+        m_gameScore.add(0.5);
+        return;
+    }
+    if (record.winner == 1)
+        m_firstMoverWins++;
+    if ((record.winner == 1) == type1First)
+    {
+        m_type1Wins++;
+        m_gameScore.add(1);
+    }
+    else
+    {
+        m_type2Wins++;
+        m_gameScore.add(0);
+    }
+    int shots = shotsFired[record.winner - 1];
+    m_shotsToWin.add(shots);
+    m_shotsToWinHistogram[shots < NBUCKETS ? shots : NBUCKETS - 1]++;
+}
+
+  // type1's score in one game: 1 for a win, 0 for a loss, 1/2 if unfinished
+static double type1Score(const GameRecord& record, bool type1First)
+{
+    if (record.winner != 1  &&  record.winner != 2)
+        return 0.5;
+    return (record.winner == 1) == type1First ? 1 : 0;
+}
+
+void GameStats::addPair(const GameRecord& first, const GameRecord& second)
+{
+    add(first, true);
+    add(second, false);
+    m_pairScore.add((type1Score(first, true) + type1Score(second, false)) / 2);
+}
+
+void GameStats::merge(const GameStats& other)
+{
+    m_games += other.m_games;
+    m_unfinished += other.m_unfinished;
+    m_type1Wins += other.m_type1Wins;
+    m_type2Wins += other.m_type2Wins;
+    m_firstMoverWins += other.m_firstMoverWins;
+    m_shotsToWin.merge(other.m_shotsToWin);
+    m_wasted.merge(other.m_wasted);
+    m_gameScore.merge(other.m_gameScore);
+    m_pairScore.merge(other.m_pairScore);
+    for (int k = 0; k < NBUCKETS; k++)
+        m_shotsToWinHistogram[k] += other.m_shotsToWinHistogram[k];
+    if (other.m_timeToSink.size() > m_timeToSink.size())
+        m_timeToSink.resize(other.m_timeToSink.size());
+    for (size_t k = 0; k < other.m_timeToSink.size(); k++)
+        m_timeToSink[k].merge(other.m_timeToSink[k]);
+}
+
+long long GameStats::histogramPercentile(double fraction) const
+{
+    long long target = (long long)ceil(fraction * m_shotsToWin.count());
+    long long seen = 0;
+    for (int k = 0; k < NBUCKETS; k++)
+    {
+        seen += m_shotsToWinHistogram[k];
+        if (seen >= target  &&  seen > 0)
+            return k;
+    }
+    return NBUCKETS - 1;
+}
+
+  // Percentage with its Wilson 95% interval, which behaves near 0% and 100%
+static void printProportion(ostream& out, long long k, long long n)
+{
+    if (n == 0)
+    {
+        out << "n/a";
+        return;
+    }
+    double p = double(k) / n;
+    double z2 = Z95 * Z95;
+    double denom = 1 + z2 / n;
+    double center = (p + z2 / (2*n)) / denom;
+    double half = Z95 * sqrt(p*(1-p)/n + z2/(4.0*n*n)) / denom;
+    double low = max(0.0, center - half);
+    double high = min(1.0, center + half);
+    out << 100*p << "%, 95% CI " << 100*low << "-" << 100*high << "%";
+}
+
+void GameStats::print(ostream& out, string type1, string type2) const
+{
+    long long decided = m_type1Wins + m_type2Wins;
+    streamsize oldPrecision = out.precision(3);
+    out << "Games: " << m_games << " (" << m_unfinished << " unfinished)" << endl;
+    out << "The " << type1 << " player won " << m_type1Wins << " (";
+    printProportion(out, m_type1Wins, decided);
+    out << ")" << endl;
+    out << "The " << type2 << " player won " << m_type2Wins << " (";
+    printProportion(out, m_type2Wins, decided);
+    out << ")" << endl;
+    out << "The first mover won ";
+    printProportion(out, m_firstMoverWins, decided);
+    out << " of decided games" << endl;
+    if (m_shotsToWin.count() > 0)
+    {
+        out << "Shots to win: mean " << m_shotsToWin.mean() << " +/- "
+            << m_shotsToWin.confidence() << " (sd " << sqrt(m_shotsToWin.variance())
+            << "), median " << histogramPercentile(0.5) << ", 10th-90th percentile "
+            << histogramPercentile(0.1) << "-" << histogramPercentile(0.9) << endl;
+    }
+    if (m_pairScore.count() > 1  &&  m_gameScore.count() > 1)
+    {
+          // Two unpaired games would give a mean score with half the
+          // per-game variance; pairing does better by whatever the
+          // layouts and streams had in common
+        double unpaired = m_gameScore.variance() / 2;
+        out << "Paired score for the " << type1 << " player: "
+            << m_pairScore.mean() << " +/- " << m_pairScore.confidence()
+            << " over " << m_pairScore.count() << " pairs" << endl;
+        if (unpaired > 0)
+            out << "Pairing cut the score variance to "
+                << 100 * m_pairScore.variance() / unpaired
+                << "% of two unpaired games" << endl;
+    }
+    out << "Wasted shots per game: mean " << m_wasted.mean() << " +/- "
+        << m_wasted.confidence() << endl;
+    for (size_t k = 0; k < m_timeToSink.size(); k++)
+    {
+        if (m_timeToSink[k].count() == 0)
+            continue;
+        out << "Shots to sink ship " << k << ": mean " << m_timeToSink[k].mean()
+            << " +/- " << m_timeToSink[k].confidence() << " over "
+            << m_timeToSink[k].count() << " sinkings" << endl;
+    }
+    out.precision(oldPrecision);
+}
+
+//******************** Sprt ********************************************
+
+  // The expected score of a player elo points stronger than its opponent
+static double eloToScore(double elo)
+{
+    return 1 / (1 + pow(10.0, -elo / 400));
+}
+
+Sprt::Sprt(double elo0, double elo1, double alpha, double beta)
+{
+    m_score0 = eloToScore(elo0);
+    m_score1 = eloToScore(elo1);
+    m_winWeight = log(m_score1 / m_score0);
+    m_lossWeight = log((1 - m_score1) / (1 - m_score0));
+    m_lower = log(beta / (1 - alpha));
+    m_upper = log((1 - beta) / alpha);
+}
+
+double Sprt::llr(long long wins, long long losses) const
+{
+    return wins * m_winWeight + losses * m_lossWeight;
+}
+
+  // The log-likelihood of scores with the frequencies freq (on scores
+  // 0, 1/4, ..., 1) under the likeliest distribution with mean score,
+  // less their log-likelihood under freq itself.  That distribution is
+  // freq[k] / (1 + lambda (k/4 - score)), lambda making its mean score.
+static double constrainedLogLikelihood(const double freq[5], double score)
+{
+    const int ITERATIONS = 100;
+      // Every term's denominator stays positive strictly between these
+    double low = -1 / (1 - score);
+    double high = 1 / score;
+    for (int iter = 0; iter < ITERATIONS; iter++)
+    {
+        double lambda = (low + high) / 2;
+        double slope = 0;
+        for (int k = 0; k < 5; k++)
+        {
+            double x = k / 4.0 - score;
+            slope += freq[k] * x / (1 + lambda * x);
+        }
+        if (slope > 0)
+            low = lambda;
+        else
+            high = lambda;
+    }
+    double lambda = (low + high) / 2;
+    double total = 0;
+    for (int k = 0; k < 5; k++)
+        total -= freq[k] * log(1 + lambda * (k / 4.0 - score));
+    return total;
+}
+
+double Sprt::pairLlr(const long long pairs[5]) const
+{
+      // A little of every score keeps the fit finite before every kind of
+      // pair has been seen
+    const double PRIOR = 1e-3;
+    double n = 0;
+    for (int k = 0; k < 5; k++)
+        n += pairs[k] + PRIOR;
+    double freq[5];
+    for (int k = 0; k < 5; k++)
+        freq[k] = (pairs[k] + PRIOR) / n;
+    return n * (constrainedLogLikelihood(freq, m_score1) -
+                constrainedLogLikelihood(freq, m_score0));
+}
+
+int Sprt::decide(long long wins, long long losses) const
+{
+    return verdict(llr(wins, losses));
+}
+
+int Sprt::decidePairs(const long long pairs[5]) const
+{
+    return verdict(pairLlr(pairs));
+}
+
+int Sprt::verdict(double llr) const
+{
+    if (llr >= m_upper)
+        return 1;
+    if (llr <= m_lower)
+        return -1;
+    return 0;
+}
+
+//******************** Bradley-Terry ***********************************
+
+vector<double> fitBradleyTerry(const vector<vector<long long>>& wins)
+{
+    const int MAX_ITERATIONS = 10000;
+    const double TOLERANCE = 1e-10;
+
+    int n = wins.size();
+    vector<double> gamma(n, 1);
+    for (int iter = 0; iter < MAX_ITERATIONS; iter++)
+    {
+          // Hunter's MM update: gamma_i = W_i / sum_j n_ij / (gamma_i + gamma_j)
+        vector<double> next(n);
+        double logSum = 0;
+        for (int i = 0; i < n; i++)
+        {
+            double won = 0;
+            double denom = 0;
+            for (int j = 0; j < n; j++)
+            {
+                if (j == i)
+                    continue;
+                double games = wins[i][j] + wins[j][i];
+                if (games == 0)
+                    continue;
+                won += wins[i][j] + 0.5;
+                denom += (games + 1) / (gamma[i] + gamma[j]);
+            }
+            next[i] = (denom > 0 ? won / denom : 1);
+            logSum += log(next[i]);
+        }
+
+          // Only ratios matter, so pin the geometric mean at 1
+        double scale = exp(logSum / n);
+        double change = 0;
+        for (int i = 0; i < n; i++)
+        {
+            next[i] /= scale;
+            change = max(change, fabs(log(next[i] / gamma[i])));
+        }
+        gamma = next;
+        if (change < TOLERANCE)
+            break;
+    }
+
+    vector<double> elo(n);
+    for (int i = 0; i < n; i++)
+        elo[i] = 400 * log10(gamma[i]);
+    return elo;
+}
+
+//******************** StatsAggregator *********************************
+
+StatsAggregator::StatsAggregator()
+ : m_head(nullptr)
+{}
+
+StatsAggregator::~StatsAggregator()
+{
+    Node* n = m_head.load();
+    while (n != nullptr)
+    {
+        Node* next = n->next;
+        delete n;
+        n = next;
+    }
+}
+
+void StatsAggregator::submit(const GameStats& partial)
+{
+      // Push onto a lock-free list; merging waits until someone asks
+    Node* n = new Node;
+    n->stats = partial;
+    n->next = m_head.load(memory_order_relaxed);
+    while (!m_head.compare_exchange_weak(n->next, n, memory_order_release,
+                                         memory_order_relaxed))
+        ;
+}
+
+GameStats StatsAggregator::total() const
+{
+    GameStats sum;
+    for (Node* n = m_head.load(memory_order_acquire); n != nullptr; n = n->next)
+        sum.merge(n->stats);
+    return sum;
+}
@@ -0,0 +1,129 @@
+#ifndef STATS_INCLUDED
+#define STATS_INCLUDED
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include <atomic>
+
+struct GameRecord;
+
+  // Count, mean and variance of a stream of numbers in constant memory
+class RunningMoments
+{
+  public:
+    RunningMoments() : m_n(0), m_mean(0), m_m2(0) {}
+    void add(double x);
+    void merge(const RunningMoments& other);
+    long long count() const { return m_n; }
+    double mean() const { return m_mean; }
+    double variance() const;
+      // Half-width of the 95% confidence interval for the mean
+    double confidence() const;
+
+  private:
+    long long m_n;
+    double m_mean;
+    double m_m2;
+};
+
+  // Statistics for one thread's share of a match.  Every figure is a running
+  // moment or a fixed-bucket histogram, so memory doesn't grow with games.
+class GameStats
+{
+  public:
+    GameStats();
+      // type1First says whether the match's first player type moved first
+    void add(const GameRecord& record, bool type1First);
+      // A pair of games from one seed, type1 moving first in the first one;
+      // also scores the pair as a whole
+    void addPair(const GameRecord& first, const GameRecord& second);
+    void merge(const GameStats& other);
+    void print(std::ostream& out, std::string type1, std::string type2) const;
+
+    long long games() const { return m_games; }
+    long long type1Wins() const { return m_type1Wins; }
+    long long type2Wins() const { return m_type2Wins; }
+
+    static const int NBUCKETS = 201;   // shots to win; the last bucket is 200+
+
+  private:
+    long long histogramPercentile(double fraction) const;
+    long long m_games;
+    long long m_unfinished;
+    long long m_type1Wins;
+    long long m_type2Wins;
+    long long m_firstMoverWins;
+    RunningMoments m_shotsToWin;
+    RunningMoments m_wasted;
+    long long m_shotsToWinHistogram[NBUCKETS];
+    std::vector<RunningMoments> m_timeToSink;   // by shipId
+    RunningMoments m_gameScore;    // type1's score per game: 1, 1/2 or 0
+    RunningMoments m_pairScore;    // type1's mean score per pair
+};
+
+  // Wald's sequential probability ratio test between two hypotheses about
+  // how many Elo points stronger one player is than the other: elo0 (H0)
+  // and elo1 (H1), per game.  alpha is the chance of accepting H1 when H0
+  // holds and beta the chance of accepting H0 when H1 holds.  Unfinished
+  // games are left out.
+  //
+  // Paired games are tested on the same per-game hypotheses by a
+  // generalized SPRT on pair scores.  pairs[k] counts the pairs where the
+  // player scored k half points over its two games, an unfinished game
+  // counting as half a point, so a pair scores 0, 1/4, 1/2, 3/4 or 1 on
+  // average and is expected to score what one game would.  Each hypothesis
+  // is the likeliest distribution of pair scores with its expected score,
+  // so the correlation between a pair's games stays in the test.
+class Sprt
+{
+  public:
+    Sprt(double elo0, double elo1, double alpha, double beta);
+      // Log-likelihood ratio of H1 to H0 after these results
+    double llr(long long wins, long long losses) const;
+    double pairLlr(const long long pairs[5]) const;
+      // 1 if H1 is accepted, -1 if H0 is, 0 if the test needs more games
+    int decide(long long wins, long long losses) const;
+    int decidePairs(const long long pairs[5]) const;
+    double lowerBound() const { return m_lower; }
+    double upperBound() const { return m_upper; }
+
+  private:
+    int verdict(double llr) const;
+    double m_score0;        // the expected score per game under H0
+    double m_score1;        // and under H1
+    double m_winWeight;     // log(p1/p0)
+    double m_lossWeight;    // log((1-p1)/(1-p0))
+    double m_lower;
+    double m_upper;
+};
+
+  // Fit Bradley-Terry strengths to a table where wins[i][j] is how many
+  // games player i won against player j, and return them as Elo ratings
+  // averaging 0.  Every pairing that was played also counts one drawn game,
+  // so a player that never won still gets a finite rating.
+std::vector<double> fitBradleyTerry(const std::vector<std::vector<long long>>& wins);
+
+  // Collects per-thread GameStats without locking: each thread fills its own
+  // and submits it when done, and the total is merged when it's asked for.
+class StatsAggregator
+{
+  public:
+    StatsAggregator();
+    ~StatsAggregator();
+    void submit(const GameStats& partial);
+    GameStats total() const;
+      // We prevent a StatsAggregator object from being copied or assigned
+    StatsAggregator(const StatsAggregator&) = delete;
+    StatsAggregator& operator=(const StatsAggregator&) = delete;
+
+  private:
+    struct Node
+    {
+        GameStats stats;
+        Node* next;
+    };
+    std::atomic<Node*> m_head;
+};
+
+#endif // STATS_INCLUDED
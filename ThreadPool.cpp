@@ -0,0 +1,175 @@
+#include "ThreadPool.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+typedef function<void()> Task;
+
+class WorkStealingPoolImpl
+{
+  public:
+    WorkStealingPoolImpl(int nThreads);
+    ~WorkStealingPoolImpl();
+    void submit(Task task);
+    void wait();
+    int nThreads() const { return m_threads.size(); }
+
+  private:
+      // One worker's tasks; the owner works at the back, thieves at the front
+    struct Queue
+    {
+        mutex m;
+        deque<Task> tasks;
+    };
+    void run(int worker);
+    bool take(int worker, Task& task);
+    deque<Queue> m_queues;
+    vector<thread> m_threads;
+    atomic<long> m_queued;          // tasks sitting in some queue
+    atomic<long> m_unfinished;      // tasks submitted and not yet finished
+    atomic<unsigned> m_nextQueue;   // where the next outside task goes
+    mutex m_idle;
+    condition_variable m_workReady;
+    condition_variable m_allDone;
+    bool m_stopping;
+};
+
+  // The pool and worker the current thread belongs to, if any
+static thread_local WorkStealingPoolImpl* currentPool = nullptr;
+static thread_local int currentWorker = -1;
+
+WorkStealingPoolImpl::WorkStealingPoolImpl(int nThreads)
+ : m_queued(0), m_unfinished(0), m_nextQueue(0), m_stopping(false)
+{
+    if (nThreads < 1)
+        nThreads = 1;
+    m_queues.resize(nThreads);
+    for (int w = 0; w < nThreads; w++)
+        m_threads.push_back(thread(&WorkStealingPoolImpl::run, this, w));
+}
+
+WorkStealingPoolImpl::~WorkStealingPoolImpl()
+{
+    wait();
+    {
+        lock_guard<mutex> lk(m_idle);
+        m_stopping = true;
+    }
+    m_workReady.notify_all();
+    for (size_t w = 0; w < m_threads.size(); w++)
+        m_threads[w].join();
+}
+
+void WorkStealingPoolImpl::submit(Task task)
+{
+    int w;
+    if (currentPool == this)
+        w = currentWorker;
+    else
+        w = m_nextQueue++ % m_queues.size();
+    m_unfinished++;
+    {
+        lock_guard<mutex> lk(m_queues[w].m);
+        m_queues[w].tasks.push_back(move(task));
+    }
+    m_queued++;
+
+      // Taking m_idle here means a worker about to sleep either sees the
+      // new task or is already waiting for this notification
+    lock_guard<mutex> lk(m_idle);
+    m_workReady.notify_one();
+}
+
+void WorkStealingPoolImpl::wait()
+{
+    unique_lock<mutex> lk(m_idle);
+    m_allDone.wait(lk, [this]() { return m_unfinished == 0; });
+}
+
+bool WorkStealingPoolImpl::take(int worker, Task& task)
+{
+    {
+        Queue& own = m_queues[worker];
+        lock_guard<mutex> lk(own.m);
+        if (!own.tasks.empty())
+        {
+            task = move(own.tasks.back());
+            own.tasks.pop_back();
+            m_queued--;
+            return true;
+        }
+    }
+    int n = m_queues.size();
+    for (int k = 1; k < n; k++)
+    {
+        Queue& victim = m_queues[(worker + k) % n];
+        lock_guard<mutex> lk(victim.m);
+        if (!victim.tasks.empty())
+        {
+            task = move(victim.tasks.front());
+            victim.tasks.pop_front();
+            m_queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPoolImpl::run(int worker)
+{
+    currentPool = this;
+    currentWorker = worker;
+    for (;;)
+    {
+        Task task;
+        if (take(worker, task))
+        {
+            task();
+            if (--m_unfinished == 0)
+            {
+                lock_guard<mutex> lk(m_idle);
+                m_allDone.notify_all();
+            }
+            continue;
+        }
+        unique_lock<mutex> lk(m_idle);
+        m_workReady.wait(lk, [this]() { return m_stopping  ||  m_queued > 0; });
+        if (m_stopping  &&  m_queued == 0)
+            return;
+    }
+}
+
+//******************** WorkStealingPool functions **********************
+
+// These functions simply delegate to WorkStealingPoolImpl's functions.
+
+WorkStealingPool::WorkStealingPool(int nThreads)
+{
+    m_impl = new WorkStealingPoolImpl(nThreads);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    delete m_impl;
+}
+
+void WorkStealingPool::submit(function<void()> task)
+{
+    m_impl->submit(move(task));
+}
+
+void WorkStealingPool::wait()
+{
+    m_impl->wait();
+}
+
+int WorkStealingPool::nThreads() const
+{
+    return m_impl->nThreads();
+}
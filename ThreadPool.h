@@ -0,0 +1,32 @@
+#ifndef THREADPOOL_INCLUDED
+#define THREADPOOL_INCLUDED
+
+#include <functional>
+
+class WorkStealingPoolImpl;
+
+  // A fixed set of worker threads, each with its own queue of tasks.  A
+  // worker takes its newest task first and, when its queue runs dry, steals
+  // the oldest task from another's, so tasks of very different lengths
+  // still keep every thread busy.  Tasks submitted from inside a task go on
+  // that worker's own queue.
+class WorkStealingPool
+{
+  public:
+    explicit WorkStealingPool(int nThreads);
+      // Finishes every submitted task before the workers go away
+    ~WorkStealingPool();
+    void submit(std::function<void()> task);
+      // Return once every task submitted so far, and every task those
+      // submitted, has finished.  Don't call this from a task.
+    void wait();
+    int nThreads() const;
+      // We prevent a WorkStealingPool object from being copied or assigned
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  private:
+    WorkStealingPoolImpl* m_impl;
+};
+
+#endif // THREADPOOL_INCLUDED
@@ -0,0 +1,40 @@
+#include "TimeControl.h"
+#include <algorithm>
+#include <chrono>
+
+using namespace std;
+
+MoveClock::MoveClock(const TimeControl& tc)
+ : m_limits(tc), m_moveStart(Clock::now()), m_deadline(m_moveStart),
+   m_hasDeadline(false), m_used(0)
+{}
+
+void MoveClock::startMove()
+{
+    m_moveStart = Clock::now();
+    double budget = UNLIMITED_TIME;
+    if (m_limits.moveSeconds > 0)
+        budget = m_limits.moveSeconds;
+    if (m_limits.gameSeconds > 0)
+        budget = min(budget, max(0.0, m_limits.gameSeconds - m_used));
+    m_hasDeadline = (budget < UNLIMITED_TIME);
+    if (m_hasDeadline)
+        m_deadline = m_moveStart + chrono::duration_cast<Clock::duration>(
+                                            chrono::duration<double>(budget));
+}
+
+bool MoveClock::stopMove()
+{
+    Clock::time_point now = Clock::now();
+    m_used += chrono::duration<double>(now - m_moveStart).count();
+    bool overran = m_hasDeadline  &&  now > m_deadline;
+    m_hasDeadline = false;
+    return overran;
+}
+
+double MoveClock::timeLeft() const
+{
+    if (!m_hasDeadline)
+        return UNLIMITED_TIME;
+    return chrono::duration<double>(m_deadline - Clock::now()).count();
+}
@@ -0,0 +1,52 @@
+#ifndef TIMECONTROL_INCLUDED
+#define TIMECONTROL_INCLUDED
+
+#include <chrono>
+
+  // What happens to a player that takes longer than it's allowed
+enum OverrunPenalty {
+    RANDOM_SHOT,    // its shot is replaced by a random cell it hasn't shot at
+    FORFEIT         // it loses the game
+};
+
+  // What a clock reports as the time left when nothing limits the move
+const double UNLIMITED_TIME = 1e9;
+
+  // Limits on how long a computer player may think.  A limit of 0 means
+  // none; a default-constructed TimeControl has no limits at all.
+struct TimeControl
+{
+    TimeControl() : moveSeconds(0), gameSeconds(0), penalty(RANDOM_SHOT) {}
+    bool enabled() const { return moveSeconds > 0  ||  gameSeconds > 0; }
+    double moveSeconds;     // for placing the fleet and for each shot
+    double gameSeconds;     // for the whole game, placement included
+    OverrunPenalty penalty;
+};
+
+  // One player's clock for one game.  The engine starts and stops it around
+  // each move; the player can ask it how long the current move has left.
+class MoveClock
+{
+  public:
+    explicit MoveClock(const TimeControl& tc);
+    void startMove();
+      // Stop the clock, charge the move to the game total, and say whether
+      // the move went past its deadline
+    bool stopMove();
+      // Seconds until the current move's deadline: the sooner of the move
+      // limit and what's left of the game limit.  Without limits, a very
+      // large number.
+    double timeLeft() const;
+    bool expired() const { return timeLeft() <= 0; }
+    double secondsUsed() const { return m_used; }
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+    TimeControl m_limits;
+    Clock::time_point m_moveStart;
+    Clock::time_point m_deadline;
+    bool m_hasDeadline;
+    double m_used;
+};
+
+#endif // TIMECONTROL_INCLUDED
@@ -0,0 +1,201 @@
+#include "Tuner.h"
+#include "Match.h"
+#include "Stats.h"
+#include "OpponentModel.h"
+#include "Player.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+  // The tunable coordinates.  Each maps a value from 0 to 1 onto one
+  // parameter's range; the neighbor order is tuned as four priorities whose
+  // ranking gives the order.
+enum Coordinate {
+    PROBE_RADIUS, PLACEMENT_ATTEMPTS, BLOCK_FRACTION, HUNT_DRAWS,
+    PLACEMENT_DRAWS, NEIGHBOR_PRIORITY, NCOORDINATES = NEIGHBOR_PRIORITY + 4
+};
+
+const int MAX_PROBE_RADIUS = 9;
+const int MAX_PLACEMENT_ATTEMPTS = 200;
+const double MAX_BLOCK_FRACTION = 0.8;
+const int MAX_HUNT_DRAWS = 16;
+const int MAX_PLACEMENT_DRAWS = 32;
+
+  // Spall's recommended decay exponents for the step and perturbation sizes
+const double ALPHA = 0.602;
+const double GAMMA = 0.101;
+
+TunerSpec::TunerSpec()
+ : type("mediocre"), rows(10), cols(10), fleet(standardFleet()),
+   iterations(100), pairsPerIteration(50), nThreads(1), firstSeed(1),
+   a(0.1), c(0.15)
+{}
+
+  // The coordinates a player type actually reads
+static vector<int> tunedCoordinates(string type)
+{
+    vector<int> dims;
+    if (type == "mediocre")
+    {
+        dims.push_back(PROBE_RADIUS);
+        dims.push_back(PLACEMENT_ATTEMPTS);
+        dims.push_back(BLOCK_FRACTION);
+    }
+    else if (type == "good")
+    {
+          // The draws only come into play once a player has profiled its
+          // opponent in an earlier game of the same match
+        dims.push_back(HUNT_DRAWS);
+        dims.push_back(PLACEMENT_DRAWS);
+        for (int k = 0; k < 4; k++)
+            dims.push_back(NEIGHBOR_PRIORITY + k);
+    }
+    return dims;
+}
+
+static double unscale(double x, double low, double high)
+{
+    return min(1.0, max(0.0, (x - low) / (high - low)));
+}
+
+static double scale(double t, double low, double high)
+{
+    return low + t * (high - low);
+}
+
+static vector<double> toCoordinates(const PlayerParams& p)
+{
+    vector<double> t(NCOORDINATES);
+    t[PROBE_RADIUS] = unscale(p.probeRadius, 1, MAX_PROBE_RADIUS);
+      // Attempts matter by ratio, so they're tuned on a log scale
+    t[PLACEMENT_ATTEMPTS] = unscale(log(double(max(1, p.placementAttempts))),
+                                    0, log(double(MAX_PLACEMENT_ATTEMPTS)));
+    t[BLOCK_FRACTION] = unscale(p.blockFraction, 0, MAX_BLOCK_FRACTION);
+    t[HUNT_DRAWS] = unscale(p.huntDraws, 1, MAX_HUNT_DRAWS);
+    t[PLACEMENT_DRAWS] = unscale(p.placementDraws, 1, MAX_PLACEMENT_DRAWS);
+    for (int k = 0; k < 4; k++)
+    {
+        int d = p.neighborOrder[k];
+        if (d >= 0  &&  d < 4)
+            t[NEIGHBOR_PRIORITY + d] = k / 3.0;
+    }
+    return t;
+}
+
+static PlayerParams fromCoordinates(const vector<double>& t)
+{
+    PlayerParams p;
+    p.probeRadius = int(lround(scale(t[PROBE_RADIUS], 1, MAX_PROBE_RADIUS)));
+    p.placementAttempts = int(lround(exp(scale(t[PLACEMENT_ATTEMPTS], 0,
+                                       log(double(MAX_PLACEMENT_ATTEMPTS))))));
+    p.blockFraction = scale(t[BLOCK_FRACTION], 0, MAX_BLOCK_FRACTION);
+    p.huntDraws = int(lround(scale(t[HUNT_DRAWS], 1, MAX_HUNT_DRAWS)));
+    p.placementDraws = int(lround(scale(t[PLACEMENT_DRAWS], 1,
+                                        MAX_PLACEMENT_DRAWS)));
+    int order[4] = { 0, 1, 2, 3 };
+    stable_sort(order, order + 4, [&](int x, int y) {
+        return t[NEIGHBOR_PRIORITY + x] < t[NEIGHBOR_PRIORITY + y];
+    });
+    for (int k = 0; k < 4; k++)
+        p.neighborOrder[k] = order[k];
+    return p;
+}
+
+void printParams(ostream& out, string type, const PlayerParams& p)
+{
+    if (type == "mediocre")
+        out << "probe radius " << p.probeRadius << ", placement attempts "
+            << p.placementAttempts << ", block fraction " << p.blockFraction;
+    else if (type == "good")
+    {
+        out << "hunt draws " << p.huntDraws << ", placement draws "
+            << p.placementDraws << ", neighbor order";
+        static const char* const names[4] = { "left", "right", "above", "below" };
+        for (int k = 0; k < 4; k++)
+            out << (k == 0 ? " " : ", ") << names[p.neighborOrder[k] & 3];
+    }
+    else
+        out << "nothing to tune";
+    out << endl;
+}
+
+bool tunePlayer(const TunerSpec& spec, PlayerParams& best, ostream* log)
+{
+    vector<int> dims = tunedCoordinates(spec.type);
+    if (dims.empty()  ||  spec.iterations < 0  ||  spec.pairsPerIteration < 1)
+        return false;
+
+    vector<double> theta = toCoordinates(spec.start);
+    PlayerParams current = spec.start;
+      // The perturbations come from their own stream, so the games' seeds
+      // alone decide what the players do
+    mt19937 directions(spec.firstSeed);
+    double stability = spec.iterations / 10.0;
+
+    for (int k = 0; k < spec.iterations; k++)
+    {
+        double ak = spec.a / pow(k + 1 + stability, ALPHA);
+        double ck = spec.c / pow(k + 1, GAMMA);
+        vector<double> delta(NCOORDINATES, 0);
+        vector<double> plus = theta;
+        vector<double> minus = theta;
+        for (size_t d = 0; d < dims.size(); d++)
+        {
+            int i = dims[d];
+            delta[i] = (directions() & 1) ? 1 : -1;
+            plus[i] = min(1.0, max(0.0, theta[i] + ck * delta[i]));
+            minus[i] = min(1.0, max(0.0, theta[i] - ck * delta[i]));
+        }
+
+          // The two candidates meet on the same seeds with sides swapped,
+          // so the luck of the layouts and the streams cancels between them
+        MatchSpec match;
+        match.rows = spec.rows;
+        match.cols = spec.cols;
+        match.fleet = spec.fleet;
+        match.type1 = spec.type;
+        match.type2 = spec.type;
+        match.params1 = fromCoordinates(plus);
+        match.params2 = fromCoordinates(minus);
+        match.nGames = 2 * spec.pairsPerIteration;
+        match.nThreads = spec.nThreads;
+        match.firstSeed = spec.firstSeed + k * spec.pairsPerIteration;
+        match.paired = true;
+          // What the candidates learn about each other carries through the
+          // iteration's games, but not into the next iteration's, whose
+          // candidates play differently under the same names
+        OpponentModels models;
+        match.models = &models;
+        StatsAggregator stats;
+        if (!runMatch(match, stats))
+            return false;
+        GameStats total = stats.total();
+        long long decided = total.type1Wins() + total.type2Wins();
+        if (decided == 0)
+            continue;
+        double score = double(total.type1Wins()) / decided;
+
+          // (f(plus) - f(minus)) / (2 ck delta_i), with f(plus) - f(minus)
+          // estimated as plus's score advantage 2*score - 1
+        double g = (2 * score - 1) / (2 * ck);
+        for (size_t d = 0; d < dims.size(); d++)
+        {
+            int i = dims[d];
+            theta[i] = min(1.0, max(0.0, theta[i] + ak * g * delta[i]));
+        }
+        current = fromCoordinates(theta);
+
+        if (log != nullptr  &&  (k + 1) % 10 == 0)
+        {
+            *log << "Iteration " << k + 1 << ": ";
+            printParams(*log, spec.type, current);
+        }
+    }
+    best = current;
+    return true;
+}
@@ -0,0 +1,45 @@
+#ifndef TUNER_INCLUDED
+#define TUNER_INCLUDED
+
+#include "Match.h"
+#include "Player.h"
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+  // How to tune one computer player type's PlayerParams by self-play
+struct TunerSpec
+{
+    TunerSpec();
+    std::string type;
+    PlayerParams start;
+    int rows;
+    int cols;
+    std::vector<ShipSpec> fleet;
+    int iterations;
+    int pairsPerIteration;
+    int nThreads;
+    unsigned firstSeed;
+      // SPSA gains, in units where each parameter's range is 0 to 1: a
+      // scales the steps and c the perturbations
+    double a;
+    double c;
+};
+
+  // Tune spec.type's parameters with simultaneous perturbation stochastic
+  // approximation (SPSA).  Each iteration perturbs every parameter the type
+  // uses up or down at random, and plays the two perturbed players against
+  // each other as a paired match on spec.nThreads threads, so both see the
+  // same seeds, layouts and shooting streams, and carry what they learn
+  // about each other from game to game, so parameters that only act on
+  // that history are tuned too.  The score of that match estimates the
+  // gradient.  If log isn't null, progress is written to it
+  // every tenth iteration.  Returns false, leaving best alone, if the spec
+  // can't be played or the type has nothing to tune.
+bool tunePlayer(const TunerSpec& spec, PlayerParams& best,
+                std::ostream* log = nullptr);
+
+  // One line listing the parameters type uses
+void printParams(std::ostream& out, std::string type, const PlayerParams& params);
+
+#endif // TUNER_INCLUDED
@@ -19,15 +19,27 @@ class Point
     int c;
 };
 
+  // The engine behind randInt.  Each thread has its own, so games played on
+  // different threads neither race on it nor disturb each other's streams.
+inline std::mt19937& randomEngine()
+{
+    static thread_local std::mt19937 generator(std::random_device{}());
+    return generator;
+}
+
+  // Restart this thread's random stream so what follows is reproducible
+inline void seedRandInt(unsigned seed)
+{
+    randomEngine().seed(seed);
+}
+
   // Return a uniformly distributed random int from 0 to limit-1
 inline int randInt(int limit)
 {
-    static std::random_device rd;
-    static std::mt19937 generator(rd());
     if (limit < 1)
         limit = 1;
     std::uniform_int_distribution<> distro(0, limit-1);
-    return distro(generator);
+    return distro(randomEngine());
 }
 
 #endif // GLOBALS_INCLUDED
@@ -1,23 +1,62 @@
 #include "Game.h"
+#include "Board.h"
 #include "Player.h"
+#include "OpeningBook.h"
+#include "ReplayLog.h"
+#include "Resimulate.h"
+#include "Match.h"
+#include "Stats.h"
+#include "League.h"
+#include "ShardedLeague.h"
+#include "Tuner.h"
+#include "AsyncGame.h"
+#include "GameRecord.h"
+#include "GameServer.h"
+#include "EnginePlayer.h"
+#include "CommandLine.h"
+#include "FreeForAll.h"
+#include "KnowledgeCache.h"
+#include "BatchSim.h"
+#include "OpponentModel.h"
 #include <iostream>
+#include <chrono>
 #include <string>
+#include <thread>
+#include <memory>
+#include <vector>
 
 using namespace std;
 
 bool addStandardShips(Game& g)
 {
-    return g.addShip(7, 'J', "jello")  &&
-            g.addShip(5, 'A', "aircraft carrier")  &&
-           g.addShip(4, 'B', "battleship")  &&
-           g.addShip(3, 'D', "destroyer")  &&
-           g.addShip(3, 'S', "submarine")  &&
-           g.addShip(1, 'P', "patrol boat");
+    return addFleet(g, standardFleet());
 }
 
-int main()
+int main(int argc, char* argv[])
 {
     const int NTRIALS = 10;
+    const char* const BOOKFILE = "standard.book";
+    const int BOOKDEPTH = 12;
+    const int NSIMULATED = 1000;
+    const char* const REPLAYFILE = "match.replay";
+    const int SPRTCAP = 20000;
+    const char* const SHARDPREFIX = "league";
+    const int NSHARDS = 16;
+    const int SHARDEDGAMES = 4000;
+    const int NTUNINGITERATIONS = 100;
+    const char* const SOCKETFILE = "battleship.sock";
+    const int NSESSIONS = 200;
+    const int GAMESPERSESSION = 5;
+    const int NENGINEGAMES = 200;
+    const int NBATCHGAMES = 200000;
+    const int NPLACEMENTS = 1000;
+
+      // Any arguments mean a run for a script, with no menu
+    if (argc > 1)
+        return runCommandLine(argc, argv);
+
+      // Good players use the opening book if one has been generated
+    loadOpeningBook(BOOKFILE);
 
     cout << "Select one of these choices for an example of the game:" << endl;
     cout << "  1.  A mini-game between two mediocre players" << endl;
@@ -25,6 +64,40 @@ int main()
     cout << "  3.  A " << NTRIALS
          << "-game match between a mediocre and an awful player, with no pauses"
          << endl;
+    cout << "  4.  Generate the opening book for the standard game" << endl;
+    cout << "  5.  A " << NSIMULATED
+         << "-game match between a mediocre and a good player, simulated"
+         << " without output" << endl;
+    cout << "  6.  Re-simulate the games recorded in " << REPLAYFILE << endl;
+    cout << "  7.  Fast-forward a game in " << REPLAYFILE
+         << " to a given shot" << endl;
+    cout << "  8.  The match in choice 5 played as pairs of games with the"
+         << " layouts swapped" << endl;
+    cout << "  9.  A mediocre player against an awful one, stopped as soon as"
+         << " the result is settled" << endl;
+    cout << " 10.  A league ranking every computer player type on several"
+         << " boards and fleets" << endl;
+    cout << " 11.  A " << SHARDEDGAMES << "-game-per-pairing league in "
+         << NSHARDS << " checkpointed processes, resuming any earlier run"
+         << endl;
+    cout << " 12.  Tune the mediocre player's parameters by self-play, then"
+         << " match it against the defaults" << endl;
+    cout << " 13.  The match in choice 5 with every game interleaved on a few"
+         << " threads through the async player interface" << endl;
+    cout << " 14.  Serve games on " << SOCKETFILE << " and load-test it with "
+         << NSESSIONS << " simultaneous clients" << endl;
+    cout << " 15.  A " << NENGINEGAMES << "-game match between a mediocre"
+         << " player and a good one run as an external engine" << endl;
+    cout << " 16.  A salvo game between a mediocre and a good player, each"
+         << " firing one shot per ship it has left" << endl;
+    cout << " 17.  Free-for-all games of 16 computer players at one table"
+         << endl;
+    cout << " 18.  A game with L, T and plus shaped ships, then a " << NSIMULATED
+         << "-game match with that fleet" << endl;
+    cout << " 19.  " << NBATCHGAMES << " games of a random hunter against a"
+         << " checkerboard one, played in lockstep batches" << endl;
+    cout << " 20.  Time " << NPLACEMENTS << " mediocre fleet placements on a"
+         << " crowded board on one thread, then on every core" << endl;
     cout << "Enter your choice: ";
     string line;
     getline(cin,line);
@@ -32,6 +105,239 @@ int main()
     {
         cout << "You did not enter a choice" << endl;
     }
+    else if (line == "10")
+    {
+        LeagueSpec spec;
+        spec.nThreads = max(1u, thread::hardware_concurrency());
+        LeagueResult result;
+        if (!runLeague(spec, result))
+            cout << "The league could not be set up." << endl;
+        else
+            result.print(cout);
+    }
+    else if (line == "11")
+    {
+        LeagueSpec spec;
+        spec.gamesPerPairing = SHARDEDGAMES;
+        LeagueResult result;
+        bool complete = runShardedLeague(spec, NSHARDS,
+                                max(1u, thread::hardware_concurrency()),
+                                SHARDPREFIX, result);
+        result.print(cout);
+        if (!complete)
+            cout << "Some shards did not finish; choose this again to resume"
+                 << " them." << endl;
+    }
+    else if (line == "12")
+    {
+        TunerSpec spec;
+        spec.type = "mediocre";
+        spec.iterations = NTUNINGITERATIONS;
+        spec.nThreads = max(1u, thread::hardware_concurrency());
+        PlayerParams tuned;
+        cout << "Starting from: ";
+        printParams(cout, spec.type, spec.start);
+        if (!tunePlayer(spec, tuned, &cout))
+            cout << "The tuner could not be set up." << endl;
+        else
+        {
+              // Fresh seeds, so the check isn't scored on the games it
+              // was tuned on
+            MatchSpec match;
+            match.type1 = spec.type;
+            match.type2 = spec.type;
+            match.params1 = tuned;
+            match.nGames = NSIMULATED;
+            match.nThreads = spec.nThreads;
+            match.firstSeed = spec.firstSeed +
+                              spec.iterations * spec.pairsPerIteration;
+            match.paired = true;
+            StatsAggregator stats;
+            runMatch(match, stats);
+            cout << "Tuned (type 1) against the defaults (type 2):" << endl;
+            stats.total().print(cout, "tuned " + spec.type,
+                                "default " + spec.type);
+        }
+    }
+    else if (line == "13")
+    {
+        Game g(10, 10);
+        addStandardShips(g);
+        GameScheduler scheduler(max(1u, thread::hardware_concurrency()));
+        vector<unique_ptr<OpponentModels>> models;
+        vector<unique_ptr<AsyncPlayer>> players;
+        vector<GameRecord> records(NSIMULATED);
+        for (int k = 0; k < NSIMULATED; k++)
+        {
+              // Alternate who moves first, as runMatch does, but keep what
+              // the players learn to the game, since interleaved games have
+              // no order to carry it across in
+            Player* good = createPlayer("good", "good (1)", g);
+            Player* mediocre = createPlayer("mediocre", "mediocre (2)", g);
+            models.emplace_back(new OpponentModels);
+            good->setOpponentModels(models.back().get());
+            mediocre->setOpponentModels(models.back().get());
+            players.emplace_back(new SyncPlayerAdapter(k % 2 == 0 ? good : mediocre));
+            players.emplace_back(new SyncPlayerAdapter(k % 2 == 0 ? mediocre : good));
+            scheduler.add(g, *players[2*k], *players[2*k+1], k + 1, &records[k]);
+        }
+        scheduler.run();
+        GameStats stats;
+        for (int k = 0; k < NSIMULATED; k++)
+            stats.add(records[k], k % 2 == 0);
+        stats.print(cout, "good", "mediocre");
+    }
+    else if (line == "14")
+    {
+        GameServer server;
+        if (!server.open(SOCKETFILE, max(1u, thread::hardware_concurrency())))
+            cout << "The server could not listen on " << SOCKETFILE << endl;
+        else
+        {
+            thread serving(&GameServer::serve, &server);
+            LoadReport report;
+            bool ran = runLoadGenerator(SOCKETFILE, NSESSIONS, GAMESPERSESSION,
+                                        "mediocre", report);
+            server.stop();
+            serving.join();
+            if (!ran)
+                cout << "The load generator could not connect." << endl;
+            else
+                report.print(cout);
+            cout << "The server finished " << server.gamesPlayed() << " games"
+                 << endl;
+        }
+    }
+    else if (line == "15")
+    {
+          // This program serves as the engine, started with --engine
+        MatchSpec match;
+        match.type1 = string(ENGINE_PREFIX) + argv[0] + " --engine good";
+        match.type2 = "mediocre";
+        match.nGames = NENGINEGAMES;
+        match.nThreads = max(1u, thread::hardware_concurrency());
+        StatsAggregator stats;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        if (!runMatch(match, stats))
+            cout << "The engine could not be started." << endl;
+        else
+        {
+            stats.total().print(cout, "good engine", "mediocre");
+            cout << "Took " << chrono::duration<double>(
+                        chrono::steady_clock::now() - start).count()
+                 << " s" << endl;
+        }
+    }
+    else if (line == "16")
+    {
+        Game g(10, 10);
+        addStandardShips(g);
+        g.setSalvo(SALVO_SURVIVING_SHIPS);
+        Player* p1 = createPlayer("mediocre", "Mediocre Mimi", g);
+        Player* p2 = createPlayer("good", "Good Gus", g);
+        g.play(p1, p2, false);
+        delete p1;
+        delete p2;
+    }
+    else if (line == "17")
+    {
+        FreeForAllSpec spec;
+        spec.nGames = NSIMULATED;
+        spec.nThreads = max(1u, thread::hardware_concurrency());
+        FreeForAllResult result;
+        if (!runFreeForAll(spec, result))
+            cout << "The games could not be set up." << endl;
+        else
+            result.print(cout);
+    }
+    else if (line == "18")
+    {
+        MatchSpec match;
+        match.fleet.clear();
+        match.fleet.push_back(ShipSpec("X./X./XX", 'L', "ell"));
+        match.fleet.push_back(ShipSpec("XXX/.X.", 'T', "tee"));
+        match.fleet.push_back(ShipSpec(".X./XXX/.X.", 'P', "plus"));
+        match.fleet.push_back(ShipSpec(4, 'B', "battleship"));
+        match.fleet.push_back(ShipSpec(2, 'D', "destroyer"));
+        Game g(10, 10);
+        addFleet(g, match.fleet);
+        Player* p1 = createPlayer("mediocre", "Mediocre Mimi", g);
+        Player* p2 = createPlayer("good", "Good Gus", g);
+        g.play(p1, p2, false);
+        delete p1;
+        delete p2;
+
+        match.nGames = NSIMULATED;
+        match.nThreads = max(1u, thread::hardware_concurrency());
+        StatsAggregator stats;
+        if (runMatch(match, stats))
+        {
+            stats.total().print(cout, "mediocre", "good");
+            cout << "Placement counts found in the knowledge cache: "
+                 << knowledgeCache().hits() << " of "
+                 << knowledgeCache().lookups() << endl;
+        }
+    }
+    else if (line == "19")
+    {
+        BatchSpec spec;
+        spec.nGames = NBATCHGAMES;
+        spec.nThreads = max(1u, thread::hardware_concurrency());
+        BatchResult result;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        if (!runBatch(spec, result))
+            cout << "The games could not be set up." << endl;
+        else
+        {
+            result.print(cout, spec.type1, spec.type2);
+            cout << "Took " << chrono::duration<double>(
+                        chrono::steady_clock::now() - start).count()
+                 << " s" << endl;
+        }
+    }
+    else if (line == "20")
+    {
+          // The standard fleet on a 9x9 board, where many blocked-board
+          // attempts fail, so there are attempts to spread across threads
+        Game g(9, 9);
+        addStandardShips(g);
+        int nThreads = max(1u, thread::hardware_concurrency());
+        vector<int> layouts[2];
+        for (int pass = 0; pass < 2; pass++)
+        {
+            int n = (pass == 0 ? 1 : nThreads);
+            setPlacementThreads(n);
+            int nPlaced = 0;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            for (int k = 0; k < NPLACEMENTS; k++)
+            {
+                seedRandInt(k + 1);
+                Board b(g);
+                unique_ptr<Player> p(createPlayer("mediocre", "Mediocre Mimi", g));
+                if (p->placeShips(b))
+                    nPlaced++;
+                for (int s = 0; s < g.nShips(); s++)
+                {
+                    Point topOrLeft;
+                    int orientation = -1;
+                    b.shipPlacement(s, topOrLeft, orientation);
+                    layouts[pass].push_back(topOrLeft.r);
+                    layouts[pass].push_back(topOrLeft.c);
+                    layouts[pass].push_back(orientation);
+                }
+            }
+            cout << "On " << n << " thread" << (n == 1 ? "" : "s")
+                 << ": placed " << nPlaced
+                 << " fleets in " << chrono::duration<double>(
+                        chrono::steady_clock::now() - start).count()
+                 << " s" << endl;
+        }
+        setPlacementThreads(1);
+        if (layouts[0] == layouts[1])
+            cout << "Every fleet went in the same place both times." << endl;
+        else
+            cout << "Some fleets went in different places!" << endl;
+    }
     else if (line[0] == '1')
     {
         Game g(2, 3);
@@ -49,6 +355,7 @@ int main()
         addStandardShips(g);
         Player* p1 = createPlayer("mediocre", "Mediocre Midori", g);
         Player* p2 = createPlayer("human", "Shuman the Human", g);
+        g.setSpeculation(true);
         g.play(p1, p2);
         delete p1;
         delete p2;
@@ -56,6 +363,9 @@ int main()
     else if (line[0] == '3')
     {
         int nMediocreWins = 0;
+        GameStats stats;
+        ReplayWriter log;
+        bool logging = log.open(REPLAYFILE);
 
         for (int k = 1; k <= NTRIALS; k++)
         {
@@ -69,15 +379,105 @@ int main()
                                 g.play(p1, p2, false) : g.play(p2, p1, false));
             if (winner == p2)
                 nMediocreWins++;
+            stats.add(g.lastRecord(), k % 2 == 1);
+            if (logging)
+            {
+                if (k % 2 == 1)
+                    log.append(g, "awful", "mediocre");
+                else
+                    log.append(g, "mediocre", "awful");
+            }
             delete p1;
             delete p2;
         }
         cout << "The mediocre player won " << nMediocreWins << " out of "
              << NTRIALS << " games." << endl;
+        stats.print(cout, "awful", "mediocre");
+        if (logging)
+            cout << "The games were added to " << REPLAYFILE << "." << endl;
           // We'd expect a mediocre player to win most of the games against
           // an awful player.  Similarly, a good player should outperform
           // a mediocre player.
     }
+    else if (line[0] == '4')
+    {
+        Game g(10, 10);
+        addStandardShips(g);
+        if (generateOpeningBook(g, BOOKDEPTH, BOOKFILE))
+            cout << "Wrote the " << BOOKDEPTH << "-shot opening book to "
+                 << BOOKFILE << "." << endl;
+        else
+            cout << "Could not write " << BOOKFILE << "." << endl;
+    }
+    else if (line[0] == '5'  ||  line[0] == '8')
+    {
+        MatchSpec spec;
+        spec.paired = (line[0] == '8');
+        spec.type1 = "good";
+        spec.type2 = "mediocre";
+        spec.nGames = NSIMULATED;
+        spec.nThreads = max(1u, thread::hardware_concurrency());
+        StatsAggregator stats;
+        runMatch(spec, stats);
+        stats.total().print(cout, spec.type1, spec.type2);
+    }
+    else if (line[0] == '9')
+    {
+        MatchSpec spec;
+        spec.type1 = "mediocre";
+        spec.type2 = "awful";
+        spec.nGames = SPRTCAP;
+        spec.nThreads = max(1u, thread::hardware_concurrency());
+        spec.sprt = true;
+        StatsAggregator stats;
+        int verdict = 0;
+        runMatch(spec, stats, &verdict);
+        GameStats total = stats.total();
+        if (verdict > 0)
+            cout << "The mediocre player is at least " << spec.elo1;
+        else if (verdict < 0)
+            cout << "The mediocre player is at most " << spec.elo0;
+        else
+            cout << "No decision after " << SPRTCAP << " games on whether the"
+                 << " mediocre player is " << spec.elo0 << " or " << spec.elo1;
+        cout << " Elo points stronger than the awful player";
+        if (verdict != 0)
+            cout << " (decided after " << total.games() << " games)";
+        cout << "." << endl;
+        total.print(cout, spec.type1, spec.type2);
+    }
+    else if (line[0] == '6')
+    {
+        int nGames = 0;
+        int nDiverged = resimulateLog(REPLAYFILE, nGames);
+        if (nDiverged < 0)
+            cout << "Could not read " << REPLAYFILE << "." << endl;
+        else
+            cout << nGames - nDiverged << " out of " << nGames
+                 << " games were reproduced exactly." << endl;
+    }
+    else if (line[0] == '7')
+    {
+        int gameNumber = 0;
+        int shot = 0;
+        cout << "Enter the game number and the shot to stop after (e.g., 3 40): ";
+        cin >> gameNumber >> shot;
+        ReplayReader reader;
+        ReplayGame game;
+        bool found = reader.open(REPLAYFILE);
+        for (int k = 1; found  &&  k <= gameNumber; k++)
+            found = reader.next(game);
+        if (!found  ||  gameNumber < 1)
+            cout << "There is no game " << gameNumber << " in " << REPLAYFILE
+                 << "." << endl;
+        else
+        {
+            ResimResult result = resimulate(game, shot, true);
+            if (!result.matched)
+                cout << "The game diverged from the log: " << result.detail
+                     << endl;
+        }
+    }
     else
     {
        cout << "That's not one of the choices." << endl;